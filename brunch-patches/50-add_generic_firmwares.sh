@@ -11,6 +11,17 @@ do
 	if [ "$i" == "invert_camera_order" ]; then invert_camera_order=1; fi
 done
 
+# Record the newest installed ucode of each iwlwifi firmware prefix so that the driver requests it directly instead of probing every older revision
+iwlwifi_fw_name_hint()
+{
+rm -f /roota/etc/modprobe.d/iwlwifi-fw.conf
+hint=$(ls /roota/lib/firmware | sed -n 's@^\(iwlwifi-.*-\)\([0-9]*\)\.ucode$@\1 \2@p' | sort -k1,1 -k2,2nr | awk '!seen[$1]++ { printf "%s%s%s.ucode", sep, $1, $2; sep = "," }')
+if [ -z "$hint" ]; then return 0; fi
+cat >/roota/etc/modprobe.d/iwlwifi-fw.conf <<MODPROBE
+options iwlwifi fw_name_hint=$hint
+MODPROBE
+}
+
 if [ "$native_chromebook_image" -eq 1 ]; then
 rm -r /roota/lib/firmware/iwlwifi*
 if [ ! "$?" -eq 0 ]; then ret=$((ret + (2 ** 0))); fi
@@ -18,6 +29,8 @@ tar zxf /rootc/packages/firmwares.tar.gz -C /tmp
 if [ ! "$?" -eq 0 ]; then ret=$((ret + (2 ** 1))); fi
 cp /tmp/iwlwifi* /roota/lib/firmware/
 if [ ! "$?" -eq 0 ]; then ret=$((ret + (2 ** 2))); fi
+iwlwifi_fw_name_hint
+if [ ! "$?" -eq 0 ]; then ret=$((ret + (2 ** 3))); fi
 exit $ret
 fi
 
@@ -30,6 +43,8 @@ if [ ! "$?" -eq 0 ]; then ret=$((ret + (2 ** 1))); fi
 tar zxf /rootc/packages/alsa-ucm-conf.tar.gz -C /roota/usr/share/alsa
 if [ ! "$?" -eq 0 ]; then ret=$((ret + (2 ** 2))); fi
 if [ ! "$(cat /proc/version | cut -d' ' -f3 | cut -c1-4 | sed 's@\.@@g')" -eq 515 ]; then rm -f /roota/lib/firmware/*.pnvm; fi
+iwlwifi_fw_name_hint
+if [ ! "$?" -eq 0 ]; then ret=$((ret + (2 ** 5))); fi
 
 if [ "$no_camera_config" -eq 1 ]; then
 cat >/roota/etc/init/camera.conf <<CAMERASCRIPT
@@ -2263,7 +2263,8 @@ static u32 iwl_dump_ini_trigger(struct iwl_fw_runtime *fwrt,
 	int i;
 	u32 size = 0;
 	u64 regions_mask = le64_to_cpu(trigger->regions_mask) &
-			   ~(fwrt->trans->dbg.unsupported_region_msk);
+			   ~(fwrt->trans->dbg.unsupported_region_msk) &
+			   fwrt->dump.region_mask;
 
 	BUILD_BUG_ON(sizeof(trigger->regions_mask) != sizeof(regions_mask));
 	BUILD_BUG_ON((sizeof(trigger->regions_mask) * BITS_PER_BYTE) <
@@ -2367,6 +2368,143 @@ static inline void iwl_fw_free_dump_desc(struct iwl_fw_runtime *fwrt,
 	fwrt->dump.umac_err_id = 0;
 }
 
+static void iwl_dump_ini_list_free(struct list_head *list)
+{
+	while (!list_empty(list)) {
+		struct iwl_fw_ini_dump_entry *entry =
+			list_entry(list->next, typeof(*entry), list);
+
+		list_del(&entry->list);
+		vfree(entry);
+	}
+}
+
+/*
+ * Streaming dumps: instead of copying everything that was collected into a
+ * second, page by page allocated, sgtable the collected buffers themselves
+ * are handed to devcoredump, which reads from them on demand and frees them
+ * once the dump was read or timed out. This halves the peak memory needed for
+ * a dump and the dump worker (and with it the restart) no longer waits for
+ * the copy.
+ */
+struct iwl_fw_dump_stream {
+	void *fwrt_ptr;
+	u32 fwrt_len;
+	struct iwl_trans_dump_data *trans_ptr;
+	struct list_head entries;
+};
+
+/* copy the part of the @len bytes at @data the request still covers */
+static size_t iwl_fw_dump_stream_chunk(char *buffer, loff_t *offset,
+				       size_t *count, const void *data,
+				       size_t len)
+{
+	size_t n;
+
+	if (*offset >= len) {
+		*offset -= len;
+		return 0;
+	}
+
+	n = min_t(size_t, *count, len - *offset);
+	memcpy(buffer, data + *offset, n);
+	*offset = 0;
+	*count -= n;
+
+	return n;
+}
+
+static ssize_t iwl_fw_dump_stream_read(char *buffer, loff_t offset,
+				       size_t count, void *data,
+				       size_t datalen)
+{
+	struct iwl_fw_dump_stream *stream = data;
+	struct iwl_fw_ini_dump_entry *entry;
+	size_t done = 0;
+
+	if (offset >= datalen)
+		return 0;
+
+	count = min_t(size_t, count, datalen - offset);
+
+	if (stream->fwrt_ptr)
+		done += iwl_fw_dump_stream_chunk(buffer + done, &offset,
+						 &count, stream->fwrt_ptr,
+						 stream->fwrt_len);
+	if (stream->trans_ptr && count)
+		done += iwl_fw_dump_stream_chunk(buffer + done, &offset,
+						 &count,
+						 stream->trans_ptr->data,
+						 stream->trans_ptr->len);
+
+	list_for_each_entry(entry, &stream->entries, list) {
+		if (!count)
+			break;
+		done += iwl_fw_dump_stream_chunk(buffer + done, &offset,
+						 &count, entry->data,
+						 entry->size);
+	}
+
+	return done;
+}
+
+static void iwl_fw_dump_stream_free(void *data)
+{
+	struct iwl_fw_dump_stream *stream = data;
+
+	vfree(stream->fwrt_ptr);
+	vfree(stream->trans_ptr);
+	iwl_dump_ini_list_free(&stream->entries);
+	kfree(stream);
+}
+
+/*
+ * Hand the dump over to devcoredump without copying it. On success the
+ * buffers in @ptrs and @entries belong to devcoredump and are cleared here.
+ */
+static bool iwl_fw_dump_stream(struct iwl_fw_runtime *fwrt,
+			       struct iwl_fw_dump_ptrs *ptrs,
+			       struct list_head *entries, u32 len)
+{
+	struct iwl_fw_dump_stream *stream;
+
+	if (!fwrt->dump.stream)
+		return false;
+
+	stream = kzalloc(sizeof(*stream), GFP_KERNEL);
+	if (!stream)
+		return false;
+
+	INIT_LIST_HEAD(&stream->entries);
+	if (ptrs) {
+		stream->fwrt_ptr = ptrs->fwrt_ptr;
+		stream->fwrt_len = ptrs->fwrt_len;
+		stream->trans_ptr = ptrs->trans_ptr;
+		ptrs->fwrt_ptr = NULL;
+		ptrs->trans_ptr = NULL;
+	}
+	if (entries)
+		list_splice_init(entries, &stream->entries);
+
+	dev_coredumpm(fwrt->trans->dev, THIS_MODULE, stream, len, GFP_KERNEL,
+		      iwl_fw_dump_stream_read, iwl_fw_dump_stream_free);
+
+	return true;
+}
+
+static void iwl_fw_dump_account(struct iwl_fw_runtime *fwrt, ktime_t start,
+				u32 len)
+{
+	u32 usecs = ktime_us_delta(ktime_get(), start);
+
+	fwrt->dump.last_len = len;
+	fwrt->dump.last_time_us = usecs;
+	fwrt->dump.count++;
+
+	IWL_DEBUG_FW_INFO(fwrt, "WRT: %s dump of %u bytes took %u usec\n",
+			  fwrt->dump.stream ? "streamed" : "copied", len, usecs);
+}
+
 static void iwl_fw_error_dump(struct iwl_fw_runtime *fwrt,
 			      struct iwl_fwrt_dump_data *dump_data)
 {
@@ -2375,6 +2513,7 @@ static void iwl_fw_error_dump(struct iwl_fw_runtime *fwrt,
 	struct scatterlist *sg_dump_data;
 	u32 file_len;
 	u32 dump_mask = fwrt->fw->dbg.dump_mask;
+	ktime_t start = ktime_get();
 
 	dump_file = iwl_fw_error_dump_file(fwrt, &fw_error_dump, dump_data);
 	if (!dump_file)
@@ -2394,6 +2533,11 @@ static void iwl_fw_error_dump(struct iwl_fw_runtime *fwrt,
 		dump_file->file_len = cpu_to_le32(file_len);
 	}
 
+	if (iwl_fw_dump_stream(fwrt, &fw_error_dump, NULL, file_len)) {
+		iwl_fw_dump_account(fwrt, start, file_len);
+		return;
+	}
+
 	sg_dump_data = alloc_sgtable(file_len);
 	if (sg_dump_data) {
 		sg_pcopy_from_buffer(sg_dump_data,
@@ -2408,22 +2552,12 @@ static void iwl_fw_error_dump(struct iwl_fw_runtime *fwrt,
 					     fw_error_dump.fwrt_len);
 		dev_coredumpsg(fwrt->trans->dev, sg_dump_data, file_len,
 			       GFP_KERNEL);
+		iwl_fw_dump_account(fwrt, start, file_len);
 	}
 	vfree(fw_error_dump.fwrt_ptr);
 	vfree(fw_error_dump.trans_ptr);
 }
 
-static void iwl_dump_ini_list_free(struct list_head *list)
-{
-	while (!list_empty(list)) {
-		struct iwl_fw_ini_dump_entry *entry =
-			list_entry(list->next, typeof(*entry), list);
-
-		list_del(&entry->list);
-		vfree(entry);
-	}
-}
-
 static void iwl_fw_error_dump_data_free(struct iwl_fwrt_dump_data *dump_data)
 {
 	dump_data->trig = NULL;
@@ -2436,11 +2570,17 @@ static void iwl_fw_error_ini_dump(struct iwl_fw_runtime *fwrt,
 {
 	struct list_head dump_list = LIST_HEAD_INIT(dump_list);
 	struct scatterlist *sg_dump_data;
+	ktime_t start = ktime_get();
 	u32 file_len = iwl_dump_ini_file_gen(fwrt, dump_data, &dump_list);
 
 	if (!file_len)
 		return;
 
+	if (iwl_fw_dump_stream(fwrt, NULL, &dump_list, file_len)) {
+		iwl_fw_dump_account(fwrt, start, file_len);
+		return;
+	}
+
 	sg_dump_data = alloc_sgtable(file_len);
 	if (sg_dump_data) {
 		struct iwl_fw_ini_dump_entry *entry;
@@ -2454,6 +2594,7 @@ static void iwl_fw_error_ini_dump(struct iwl_fw_runtime *fwrt,
 		}
 		dev_coredumpsg(fwrt->trans->dev, sg_dump_data, file_len,
 			       GFP_KERNEL);
+		iwl_fw_dump_account(fwrt, start, file_len);
 	}
 	iwl_dump_ini_list_free(&dump_list);
 }
@@ -301,6 +301,31 @@ static ssize_t iwl_dbgfs_fw_dbg_domain_read(struct iwl_fw_runtime *fwrt,
 
 FWRT_DEBUGFS_READ_FILE_OPS(fw_dbg_domain, 20);
 
+static ssize_t iwl_dbgfs_dump_stats_read(struct iwl_fw_runtime *fwrt,
+					 size_t size, char *buf)
+{
+	return scnprintf(buf, size,
+			 "dumps: %u\nlast_len: %u\nlast_time_us: %u\n",
+			 fwrt->dump.count, fwrt->dump.last_len,
+			 fwrt->dump.last_time_us);
+}
+
+FWRT_DEBUGFS_READ_FILE_OPS(dump_stats, 80);
+
+static ssize_t iwl_dbgfs_paging_stats_read(struct iwl_fw_runtime *fwrt,
+					   size_t size, char *buf)
+{
+	return scnprintf(buf, size,
+			 "mem_size: %u\nallocs: %u\nfills: %u\nreuses: %u\n"
+			 "last_alloc_us: %u\nlast_fill_us: %u\nlast_setup_us: %u\n",
+			 fwrt->paging.mem_size, fwrt->paging.allocs,
+			 fwrt->paging.fills, fwrt->paging.reuses,
+			 fwrt->paging.last_alloc_us, fwrt->paging.last_fill_us,
+			 fwrt->paging.last_setup_us);
+}
+
+FWRT_DEBUGFS_READ_FILE_OPS(paging_stats, 200);
+
 struct iwl_dbgfs_fw_info_priv {
 	struct iwl_fw_runtime *fwrt;
 };
@@ -406,4 +431,10 @@ void iwl_fwrt_dbgfs_register(struct iwl_fw_runtime *fwrt,
 	FWRT_DEBUGFS_ADD_FILE(send_hcmd, dbgfs_dir, 0200);
 	FWRT_DEBUGFS_ADD_FILE(enabled_severities, dbgfs_dir, 0200);
 	FWRT_DEBUGFS_ADD_FILE(fw_dbg_domain, dbgfs_dir, 0400);
+	FWRT_DEBUGFS_ADD_FILE(dump_stats, dbgfs_dir, 0400);
+	FWRT_DEBUGFS_ADD_FILE(paging_stats, dbgfs_dir, 0400);
+	debugfs_create_bool("dump_stream", 0600, dbgfs_dir,
+			    &fwrt->dump.stream);
+	debugfs_create_x64("dump_region_mask", 0600, dbgfs_dir,
+			   &fwrt->dump.region_mask);
 }
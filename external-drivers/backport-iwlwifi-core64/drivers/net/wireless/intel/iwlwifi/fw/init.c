@@ -27,6 +27,8 @@ void iwl_fw_runtime_init(struct iwl_fw_runtime *fwrt, struct iwl_trans *trans,
 	fwrt->fw = fw;
 	fwrt->dev = trans->dev;
 	fwrt->dump.conf = FW_DBG_INVALID;
+	fwrt->dump.stream = true;
+	fwrt->dump.region_mask = ~0ULL;
 	fwrt->ops = ops;
 	fwrt->sanitize_ops = sanitize_ops;
 	fwrt->sanitize_ctx = sanitize_ctx;
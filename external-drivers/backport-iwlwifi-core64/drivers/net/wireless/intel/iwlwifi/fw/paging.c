@@ -34,6 +34,8 @@ void iwl_free_fw_paging(struct iwl_fw_runtime *fwrt)
 	}
 
 	memset(fwrt->fw_paging_db, 0, sizeof(fwrt->fw_paging_db));
+	fwrt->paging.img = NULL;
+	fwrt->paging.mem_size = 0;
 }
 IWL_EXPORT_SYMBOL(iwl_free_fw_paging);
 
@@ -43,9 +45,19 @@ static int iwl_alloc_fw_paging_mem(struct iwl_fw_runtime *fwrt,
 	struct page *block;
 	dma_addr_t phys = 0;
 	int blk_idx, order, num_of_pages, size;
+	ktime_t start;
 
-	if (fwrt->fw_paging_db[0].fw_paging_block)
-		return 0;
+	/*
+	 * The blocks stay allocated and mapped across firmware restarts
+	 * and D3, only a different paging layout requires new ones.
+	 */
+	if (fwrt->fw_paging_db[0].fw_paging_block) {
+		if (fwrt->paging.mem_size == image->paging_mem_size)
+			return 0;
+		iwl_free_fw_paging(fwrt);
+	}
+
+	start = ktime_get();
 
 	/* ensure BLOCK_2_EXP_SIZE is power of 2 of PAGING_BLOCK_SIZE */
 	BUILD_BUG_ON(BIT(BLOCK_2_EXP_SIZE) != PAGING_BLOCK_SIZE);
@@ -102,6 +114,10 @@ static int iwl_alloc_fw_paging_mem(struct iwl_fw_runtime *fwrt,
 				     order);
 	}
 
+	fwrt->paging.mem_size = image->paging_mem_size;
+	fwrt->paging.allocs++;
+	fwrt->paging.last_alloc_us = ktime_us_delta(ktime_get(), start);
+
 	return 0;
 }
 
@@ -110,6 +126,21 @@ static int iwl_fill_paging_mem(struct iwl_fw_runtime *fwrt,
 {
 	int sec_idx, idx, ret;
 	u32 offset = 0;
+	ktime_t start;
+
+	/*
+	 * The blocks are DMA mapped bidirectionally and the firmware may
+	 * write data pages back, so they can only be reused as they are
+	 * if the firmware didn't run from them since they were filled.
+	 */
+	if (fwrt->paging.img == image && !fwrt->paging.fw_used) {
+		IWL_DEBUG_FW(fwrt, "Paging: blocks already hold the image\n");
+		fwrt->paging.reuses++;
+		return 0;
+	}
+
+	start = ktime_get();
+	fwrt->paging.img = NULL;
 
 	/*
 	 * find where is the paging image start point:
@@ -211,6 +242,11 @@ static int iwl_fill_paging_mem(struct iwl_fw_runtime *fwrt,
 		offset += block->fw_paging_size;
 	}
 
+	fwrt->paging.img = image;
+	fwrt->paging.fw_used = false;
+	fwrt->paging.fills++;
+	fwrt->paging.last_fill_us = ktime_us_delta(ktime_get(), start);
+
 	return 0;
 
 err:
@@ -265,6 +301,7 @@ static int iwl_send_paging_cmd(struct iwl_fw_runtime *fwrt,
 int iwl_init_paging(struct iwl_fw_runtime *fwrt, enum iwl_ucode_type type)
 {
 	const struct fw_img *fw = &fwrt->fw->img[type];
+	ktime_t start = ktime_get();
 	int ret;
 
 	if (fwrt->trans->trans_cfg->gen2)
@@ -287,10 +324,15 @@ int iwl_init_paging(struct iwl_fw_runtime *fwrt, enum iwl_ucode_type type)
 	ret = iwl_send_paging_cmd(fwrt, fw);
 	if (ret) {
 		IWL_ERR(fwrt, "failed to send the paging cmd\n");
-		iwl_free_fw_paging(fwrt);
 		return ret;
 	}
 
+	fwrt->paging.fw_used = true;
+	fwrt->paging.last_setup_us = ktime_us_delta(ktime_get(), start);
+	IWL_DEBUG_FW(fwrt, "Paging: setup took %u us (alloc %u us, fill %u us)\n",
+		     fwrt->paging.last_setup_us, fwrt->paging.last_alloc_us,
+		     fwrt->paging.last_fill_us);
+
 	return 0;
 }
 IWL_EXPORT_SYMBOL(iwl_init_paging);
@@ -91,6 +91,19 @@ struct iwl_txf_iter_data {
  * @fw_paging_db: paging database
  * @num_of_paging_blk: number of paging blocks
  * @num_of_pages_in_last_blk: number of pages in the last block
+ * @paging: state of the paging blocks, which are kept allocated and
+ *	DMA mapped across firmware restarts until &iwl_fw_runtime_free()
+ * @paging.img: image the paging blocks currently hold, %NULL if none
+ * @paging.mem_size: paging memory size the blocks were allocated for
+ * @paging.fw_used: the blocks were handed to the firmware since they
+ *	were last filled, so their data pages may have been written back
+ * @paging.allocs: number of times the blocks were allocated
+ * @paging.fills: number of times the blocks were filled from the image
+ * @paging.reuses: number of times the blocks were reused without a copy
+ * @paging.last_alloc_us: time the last allocation took
+ * @paging.last_fill_us: time the last copy from the image took
+ * @paging.last_setup_us: time the last complete paging setup took,
+ *	including the paging command
  * @smem_cfg: saved firmware SMEM configuration
  * @cur_fw_img: current firmware image, must be maintained by
  *	the driver by calling &iwl_fw_set_current_image()
@@ -111,6 +124,17 @@ struct iwl_fw_runtime {
 	struct iwl_fw_paging fw_paging_db[NUM_OF_FW_PAGING_BLOCKS];
 	u16 num_of_paging_blk;
 	u16 num_of_pages_in_last_blk;
+	struct {
+		const struct fw_img *img;
+		u32 mem_size;
+		bool fw_used;
+		u32 allocs;
+		u32 fills;
+		u32 reuses;
+		u32 last_alloc_us;
+		u32 last_fill_us;
+		u32 last_setup_us;
+	} paging;
 
 	enum iwl_ucode_type cur_fw_img;
 
@@ -132,6 +156,15 @@ struct iwl_fw_runtime {
 
 		struct iwl_txf_iter_data txf_iter_data;
 
+		/* hand dumps to devcoredump without copying them */
+		bool stream;
+		/* ini regions that may be dumped, by region id */
+		u64 region_mask;
+		/* size and collection time of the last dump */
+		u32 last_len;
+		u32 last_time_us;
+		u32 count;
+
 		struct {
 			u8 type;
 			u8 subtype;
@@ -168,10 +201,14 @@ void iwl_fw_runtime_init(struct iwl_fw_runtime *fwrt, struct iwl_trans *trans,
 			void *sanitize_ctx,
 			struct dentry *dbgfs_dir);
 
+void iwl_free_fw_paging(struct iwl_fw_runtime *fwrt);
+
 static inline void iwl_fw_runtime_free(struct iwl_fw_runtime *fwrt)
 {
 	int i;
 
+	iwl_free_fw_paging(fwrt);
+
 	kfree(fwrt->dump.d3_debug_data);
 	fwrt->dump.d3_debug_data = NULL;
 
@@ -191,7 +228,6 @@ static inline void iwl_fw_set_current_image(struct iwl_fw_runtime *fwrt,
 }
 
 int iwl_init_paging(struct iwl_fw_runtime *fwrt, enum iwl_ucode_type type);
-void iwl_free_fw_paging(struct iwl_fw_runtime *fwrt);
 
 void iwl_get_shared_mem_conf(struct iwl_fw_runtime *fwrt);
 int iwl_set_soc_latency(struct iwl_fw_runtime *fwrt);
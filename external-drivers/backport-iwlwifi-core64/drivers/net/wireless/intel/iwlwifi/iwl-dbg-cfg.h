@@ -124,6 +124,7 @@ struct iwl_dbg_cfg {
 	IWL_DBG_CFG(u8, MVM_RS_STAY_IN_COLUMN_TIMEOUT)
 	IWL_DBG_CFG(u8, MVM_RS_IDLE_TIMEOUT)
 	IWL_DBG_CFG(u8, MVM_RS_MISSED_RATE_MAX)
+	IWL_DBG_CFG(u8, MVM_RS_SUCCESS_BATCH)
 	IWL_DBG_CFG(u16, MVM_RS_LEGACY_FAILURE_LIMIT)
 	IWL_DBG_CFG(u16, MVM_RS_LEGACY_SUCCESS_LIMIT)
 	IWL_DBG_CFG(u16, MVM_RS_LEGACY_TABLE_COUNT)
@@ -51,7 +51,13 @@ static struct dentry *iwl_dbgfs_root;
  * @trans: transport layer
  * @dev: for debug prints only
  * @fw_index: firmware revision to try loading
+ * @fw_hint_index: revision taken from the fw_name_hint, 0 if none
+ * @fw_hint_failed: the hinted revision didn't load, probing the full chain
+ * @fw_hint_newer: probing the revision above the hint before trusting it
  * @firmware_name: composite filename of ucode file to load
+ * @fw_load_start: time the first firmware request was issued
+ * @fw_load_time_us: time it took until a usable firmware file was found
+ * @fw_load_attempts: number of firmware files requested until then
  * @request_firmware_complete: the firmware has been obtained from user space
  * @dbgfs_drv: debugfs root directory entry
  * @dbgfs_trans: debugfs transport directory entry
@@ -69,8 +75,15 @@ struct iwl_drv {
 #endif
 
 	int fw_index;                   /* firmware we're trying to load */
+	int fw_hint_index;
+	bool fw_hint_failed;
+	bool fw_hint_newer;
 	char firmware_name[64];         /* name of firmware file to load */
 
+	ktime_t fw_load_start;
+	u64 fw_load_time_us;
+	u32 fw_load_attempts;
+
 	struct completion request_firmware_complete;
 
 #ifdef CPTCFG_IWLWIFI_DEBUGFS
@@ -367,6 +380,99 @@ static int iwl_alloc_fw_desc(struct iwl_drv *drv, struct fw_desc *desc,
 static void iwl_req_fw_callback(const struct firmware *ucode_raw,
 				void *context);
 
+/*
+ * Comma separated list of ucode files, at most one per firmware name
+ * prefix, that were last loaded successfully. It is seeded with the
+ * newest installed files by the firmware install step (via modprobe.d)
+ * so that the probe requests them directly instead of walking down from
+ * api_max, and the entry of a device is updated by the driver whenever
+ * one of its firmware files is accepted.
+ */
+static char iwlwifi_fw_name_hint[1024];
+
+/*
+ * iwl_fw_hint_find - find the hint entry for the given firmware name
+ * prefix and return its api revision in @index. Must be called with the
+ * module parameter lock held.
+ */
+static char *iwl_fw_hint_find(const char *pre, int *index)
+{
+	size_t pre_len = strlen(pre);
+	char *entry = iwlwifi_fw_name_hint;
+
+	while (*entry) {
+		size_t len = strcspn(entry, ",");
+		int end = 0;
+
+		if (!strncmp(entry, pre, pre_len) &&
+		    sscanf(entry + pre_len, "%d.ucode%n", index, &end) == 1 &&
+		    pre_len + end == len)
+			return entry;
+
+		entry += len;
+		if (*entry)
+			entry++;
+	}
+
+	return NULL;
+}
+
+/*
+ * iwl_fw_hint_index - return the api revision the firmware name hint
+ * records for this device, or 0 if there is none.
+ */
+static int iwl_fw_hint_index(struct iwl_drv *drv)
+{
+	const struct iwl_cfg *cfg = drv->trans->cfg;
+	int index;
+
+	/* only api_max is allowed anyway, there's nothing to skip */
+	if (IS_ENABLED(CPTCFG_IWLWIFI_DISALLOW_OLDER_FW))
+		return 0;
+
+	kernel_param_lock(THIS_MODULE);
+	if (!iwl_fw_hint_find(cfg->fw_name_pre, &index))
+		index = 0;
+	kernel_param_unlock(THIS_MODULE);
+
+	if (index < cfg->ucode_api_min || index > cfg->ucode_api_max)
+		return 0;
+
+	return index;
+}
+
+static void iwl_fw_hint_update(struct iwl_drv *drv)
+{
+	const char *pre = drv->trans->cfg->fw_name_pre;
+	char *hint = iwlwifi_fw_name_hint;
+	char *entry;
+	size_t len;
+	int index;
+
+	kernel_param_lock(THIS_MODULE);
+
+	/* drop the old entry of this prefix, the new one is appended */
+	entry = iwl_fw_hint_find(pre, &index);
+	if (entry) {
+		len = strcspn(entry, ",");
+		if (entry[len])
+			len++;
+		memmove(entry, entry + len, strlen(entry + len) + 1);
+	}
+
+	len = strlen(hint);
+	if (len && hint[len - 1] == ',')
+		hint[--len] = '\0';
+
+	/* don't leave a truncated entry behind if the list is full */
+	if (snprintf(hint + len, sizeof(iwlwifi_fw_name_hint) - len,
+		     "%s%s%d.ucode", len ? "," : "", pre,
+		     drv->fw_index) >= sizeof(iwlwifi_fw_name_hint) - len)
+		hint[len] = '\0';
+
+	kernel_param_unlock(THIS_MODULE);
+}
+
 static int iwl_request_firmware(struct iwl_drv *drv, bool first)
 {
 	const struct iwl_cfg *cfg = drv->trans->cfg;
@@ -385,13 +491,42 @@ static int iwl_request_firmware(struct iwl_drv *drv, bool first)
 	}
 
 	if (first) {
+		drv->fw_load_start = ktime_get();
+		drv->fw_load_attempts = 0;
+		drv->fw_hint_failed = false;
+		drv->fw_hint_index = iwl_fw_hint_index(drv);
+		drv->fw_index = drv->fw_hint_index ?: cfg->ucode_api_max;
+
+		/*
+		 * The hint is only good as long as no newer revision was
+		 * installed since it was recorded, so check the next one.
+		 */
+		drv->fw_hint_newer = drv->fw_hint_index &&
+				     drv->fw_index < cfg->ucode_api_max;
+		if (drv->fw_hint_newer)
+			drv->fw_index++;
+	} else if (drv->fw_hint_newer) {
+		/* nothing newer than the hint, go for the hinted file */
+		drv->fw_hint_newer = false;
+		drv->fw_index = drv->fw_hint_index;
+	} else if (drv->fw_hint_index && !drv->fw_hint_failed) {
+		/* the hinted file didn't work out, probe the full chain */
+		IWL_DEBUG_FW_INFO(drv, "hinted firmware '%s' failed\n",
+				  drv->firmware_name);
+		drv->fw_hint_failed = true;
 		drv->fw_index = cfg->ucode_api_max;
-		sprintf(tag, "%d", drv->fw_index);
 	} else {
 		drv->fw_index--;
-		sprintf(tag, "%d", drv->fw_index);
 	}
 
+	/* no need to request the hinted file or the one above a second time */
+	if (drv->fw_hint_failed &&
+	    (drv->fw_index == drv->fw_hint_index ||
+	     drv->fw_index == drv->fw_hint_index + 1))
+		drv->fw_index = drv->fw_hint_index - 1;
+
+	sprintf(tag, "%d", drv->fw_index);
+
 #ifdef CPTCFG_IWLWIFI_DISALLOW_OLDER_FW
 	/* The dbg-cfg check here works because the first time we get
 	 * here we always load the 'api_max' version, and once that
@@ -438,6 +573,8 @@ static int iwl_request_firmware(struct iwl_drv *drv, bool first)
 	IWL_DEBUG_FW_INFO(drv, "attempting to load firmware '%s'\n",
 			  drv->firmware_name);
 
+	drv->fw_load_attempts++;
+
 	return request_firmware_nowait(THIS_MODULE, 1, drv->firmware_name,
 				       drv->trans->dev,
 				       GFP_KERNEL, drv, iwl_req_fw_callback);
@@ -1670,6 +1807,19 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 	if (!ucode_raw)
 		goto try_again;
 
+	/*
+	 * A revision newer than the hinted one showed up, so the hint is
+	 * stale and there may be even newer files: walk the whole chain.
+	 */
+	if (drv->fw_hint_newer && drv->fw_index < api_max) {
+		IWL_DEBUG_FW_INFO(drv, "'%s' is newer than the hint, ignoring it\n",
+				  drv->firmware_name);
+		drv->fw_hint_newer = false;
+		drv->fw_hint_index = 0;
+		drv->fw_index = api_max + 1;
+		goto try_again;
+	}
+
 	IWL_DEBUG_FW_INFO(drv, "Loaded firmware file '%s' (%zd bytes).\n",
 			  drv->firmware_name, ucode_raw->size);
 
@@ -1911,8 +2061,13 @@ static void iwl_req_fw_callback(const struct firmware *ucode_raw, void *context)
 	drv->xvt_mode_on = (op == &iwlwifi_opmode_table[XVT_OP_MODE]);
 #endif
 
+	drv->fw_load_time_us = ktime_us_delta(ktime_get(), drv->fw_load_start);
+	iwl_fw_hint_update(drv);
+
 	IWL_INFO(drv, "loaded firmware version %s op_mode %s\n",
 		 drv->fw.fw_version, op->name);
+	IWL_DEBUG_FW_INFO(drv, "firmware found after %u request(s) in %llu us\n",
+			  drv->fw_load_attempts, drv->fw_load_time_us);
 
 	iwl_dbg_tlv_load_bin(drv->trans->dev, drv->trans);
 
@@ -1997,6 +2152,11 @@ struct iwl_drv *iwl_drv_start(struct iwl_trans *trans)
 
 	/* Create transport layer debugfs dir */
 	drv->trans->dbgfs_dir = debugfs_create_dir("trans", drv->dbgfs_drv);
+
+	debugfs_create_u64("fw_load_time_us", 0400, drv->dbgfs_drv,
+			   &drv->fw_load_time_us);
+	debugfs_create_u32("fw_load_attempts", 0400, drv->dbgfs_drv,
+			   &drv->fw_load_attempts);
 #endif
 
 #ifdef CPTCFG_IWLWIFI_DEVICE_TESTMODE
@@ -2225,6 +2385,12 @@ MODULE_PARM_DESC(fw_restart, "restart firmware in case of error (default true)")
 module_param_named(nvm_file, iwlwifi_mod_params.nvm_file, charp, 0444);
 MODULE_PARM_DESC(nvm_file, "NVM file name");
 
+module_param_string(fw_name_hint, iwlwifi_fw_name_hint,
+		    sizeof(iwlwifi_fw_name_hint), 0644);
+MODULE_PARM_DESC(fw_name_hint,
+		 "comma separated ucode files to try first, one per firmware prefix, "
+		 "updated with the last file loaded (default: none)");
+
 module_param_named(uapsd_disable, iwlwifi_mod_params.uapsd_disable, uint, 0644);
 MODULE_PARM_DESC(uapsd_disable,
 		 "disable U-APSD functionality bitmap 1: BSS 2: P2P Client (default: 3)");
@@ -90,6 +90,9 @@ struct iwl_test_ops {
  *	received on the RSS queue(s). The queue parameter indicates which of the
  *	RSS queues received this frame; it will always be non-zero.
  *	This method must not sleep.
+ * @rx_done: called at the end of each NAPI poll of an RX queue (including
+ *	the default one) so the op_mode can hand the frames it batched during
+ *	the poll to the network stack. Optional. This method must not sleep.
  * @async_cb: called when an ASYNC command with CMD_WANT_ASYNC_CALLBACK set
  *	completes. Must be atomic.
  * @queue_full: notifies that a HW queue is full.
@@ -122,6 +125,8 @@ struct iwl_op_mode_ops {
 		   struct iwl_rx_cmd_buffer *rxb);
 	void (*rx_rss)(struct iwl_op_mode *op_mode, struct napi_struct *napi,
 		       struct iwl_rx_cmd_buffer *rxb, unsigned int queue);
+	void (*rx_done)(struct iwl_op_mode *op_mode, struct napi_struct *napi,
+			unsigned int queue);
 	void (*async_cb)(struct iwl_op_mode *op_mode,
 			 const struct iwl_device_cmd *cmd);
 	void (*queue_full)(struct iwl_op_mode *op_mode, int queue);
@@ -176,6 +181,14 @@ static inline void iwl_op_mode_rx_rss(struct iwl_op_mode *op_mode,
 	op_mode->ops->rx_rss(op_mode, napi, rxb, queue);
 }
 
+static inline void iwl_op_mode_rx_done(struct iwl_op_mode *op_mode,
+				       struct napi_struct *napi,
+				       unsigned int queue)
+{
+	if (op_mode->ops->rx_done)
+		op_mode->ops->rx_done(op_mode, napi, queue);
+}
+
 static inline void iwl_op_mode_async_cb(struct iwl_op_mode *op_mode,
 					const struct iwl_device_cmd *cmd)
 {
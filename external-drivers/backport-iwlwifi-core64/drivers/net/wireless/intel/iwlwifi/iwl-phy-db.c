@@ -144,6 +144,17 @@ void iwl_phy_db_free(struct iwl_phy_db *phy_db)
 }
 IWL_EXPORT_SYMBOL(iwl_phy_db_free);
 
+/*
+ * The PHY DB is usable for the runtime image once the INIT firmware has
+ * delivered the configuration and the non channel specific calibration
+ * sections; the channel group sections are optional.
+ */
+bool iwl_phy_db_is_valid(struct iwl_phy_db *phy_db)
+{
+	return phy_db && phy_db->cfg.data && phy_db->calib_nch.data;
+}
+IWL_EXPORT_SYMBOL(iwl_phy_db_is_valid);
+
 int iwl_phy_db_set_section(struct iwl_phy_db *phy_db,
 			   struct iwl_rx_packet *pkt)
 {
@@ -114,6 +114,16 @@ int iwl_trans_init(struct iwl_trans *trans)
 		return -ENOMEM;
 	}
 
+	trans->tpt = alloc_percpu(struct iwl_tpt_stats);
+	if (!trans->tpt) {
+		free_percpu(trans->txqs.tso_hdr_page);
+		trans->txqs.tso_hdr_page = NULL;
+		kmem_cache_destroy(trans->dev_cmd_pool);
+		return -ENOMEM;
+	}
+
+	timer_setup(&trans->txqs.stuck_timer, iwl_txq_stuck_timer, 0);
+
 	/* Initialize the wait queue for commands */
 	init_waitqueue_head(&trans->wait_command_queue);
 
@@ -124,6 +134,8 @@ void iwl_trans_free(struct iwl_trans *trans)
 {
 	int i;
 
+	del_timer_sync(&trans->txqs.stuck_timer);
+
 	if (trans->txqs.tso_hdr_page) {
 		for_each_possible_cpu(i) {
 			struct iwl_tso_hdr_page *p =
@@ -136,9 +148,29 @@ void iwl_trans_free(struct iwl_trans *trans)
 		free_percpu(trans->txqs.tso_hdr_page);
 	}
 
+	free_percpu(trans->tpt);
+
 	kmem_cache_destroy(trans->dev_cmd_pool);
 }
 
+void iwl_trans_tpt_sum(struct iwl_trans *trans, struct iwl_tpt_stats *sum)
+{
+	int cpu, i, j;
+
+	memset(sum, 0, sizeof(*sum));
+
+	for_each_possible_cpu(cpu) {
+		struct iwl_tpt_stats *p = per_cpu_ptr(trans->tpt, cpu);
+
+		for (i = 0; i < IWL_TPT_NUM_COUNTERS; i++)
+			sum->counters[i] += READ_ONCE(p->counters[i]);
+		for (i = 0; i < IWL_TPT_NUM_HISTS; i++)
+			for (j = 0; j < IWL_TPT_HIST_BUCKETS; j++)
+				sum->hist[i][j] += READ_ONCE(p->hist[i][j]);
+	}
+}
+IWL_EXPORT_SYMBOL(iwl_trans_tpt_sum);
+
 int iwl_trans_send_cmd(struct iwl_trans *trans, struct iwl_host_cmd *cmd)
 {
 	int ret;
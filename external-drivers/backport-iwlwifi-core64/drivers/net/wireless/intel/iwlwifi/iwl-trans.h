@@ -11,6 +11,7 @@
 #include <linux/mm.h> /* for page_address */
 #include <linux/lockdep.h>
 #include <linux/kernel.h>
+#include <linux/dynamic_queue_limits.h>
 
 #include "iwl-debug.h"
 #include "iwl-config.h"
@@ -805,6 +806,8 @@ struct iwl_cmd_meta {
 	struct iwl_host_cmd *source;
 	u32 flags;
 	u32 tbs;
+	/* TBs pointing into the queue's premapped header pages, not unmapped */
+	u32 hdr_tbs;
 };
 
 /*
@@ -825,6 +828,8 @@ struct iwl_pcie_txq_entry {
 	/* buffer to free after command completes */
 	const void *free_buf;
 	struct iwl_cmd_meta meta;
+	/* time the frame was put on the ring, for TX latency statistics */
+	u64 enq_ns;
 };
 
 struct iwl_pcie_first_tb_buf {
@@ -841,13 +846,14 @@ struct iwl_pcie_first_tb_buf {
  * @first_tb_dma: DMA address for the first_tb_bufs start
  * @entries: transmit entries (driver state)
  * @lock: queue lock
- * @stuck_timer: timer that fires if queue gets stuck
+ * @stuck_deadline: jiffies by which the queue must make progress, 0 if the
+ *	queue is empty or frozen; checked by &iwl_trans_txqs.stuck_timer
  * @trans: pointer back to transport (for timer)
  * @need_update: indicates need to update read/write index
  * @ampdu: true if this queue is an ampdu queue for an specific RA/TID
  * @wd_timeout: queue watchdog timeout (jiffies) - per queue
- * @frozen: tx stuck queue timer is frozen
- * @frozen_expiry_remainder: remember how long until the timer fires
+ * @frozen: tx stuck queue check is frozen
+ * @frozen_expiry_remainder: remember how long until the queue is stuck
  * @bc_tbl: byte count table of the queue (relevant only for gen2 transport)
  * @write_ptr: 1-st empty entry (index) host_w
  * @read_ptr: last used entry (index) host_r
@@ -856,6 +862,11 @@ struct iwl_pcie_first_tb_buf {
  * @id: queue id
  * @low_mark: low watermark, resume queue if free space more than this
  * @high_mark: high watermark, stop queue if free space less than this
+ * @hdr_pages: ring of DMA-mapped pages that A-MSDU subframe headers and
+ *	TB workaround copies are carved from (gen2 data queues only)
+ * @hdr_cur: index of the header page currently being carved
+ * @bql: the queue is limited in bytes by @dql as well as in frames
+ * @dql: byte queue limit state, as used by BQL for netdev queues
  *
  * A Tx queue consists of circular buffer of BDs (a.k.a. TFDs, transmit frame
  * descriptors) and required locking structures.
@@ -881,7 +892,7 @@ struct iwl_txq {
 	/* lock for syncing changes on the queue */
 	spinlock_t lock;
 	unsigned long frozen_expiry_remainder;
-	struct timer_list stuck_timer;
+	unsigned long stuck_deadline;
 	struct iwl_trans *trans;
 	bool need_update;
 	bool frozen;
@@ -900,6 +911,14 @@ struct iwl_txq {
 	int high_mark;
 
 	bool overflow_tx;
+
+	struct iwl_tso_hdr_page *hdr_pages;
+	int hdr_cur;
+
+	bool bql;
+#ifdef CONFIG_BQL
+	struct dql dql;
+#endif
 };
 
 /**
@@ -911,6 +930,8 @@ struct iwl_txq {
  * @queue_used - bit mask of used queues
  * @queue_stopped - bit mask of stopped queues
  * @scd_bc_tbls: gen1 pointer to the byte count table of the scheduler
+ * @stuck_timer: scans the queues for one that missed its progress
+ *	deadline, armed only while some queue has frames in flight
  */
 struct iwl_trans_txqs {
 	unsigned long queue_used[BITS_TO_LONGS(IWL_MAX_TVQM_QUEUES)];
@@ -936,6 +957,59 @@ struct iwl_trans_txqs {
 	} tfd;
 
 	struct iwl_dma_ptr scd_bc_tbls;
+
+	struct timer_list stuck_timer;
+};
+
+/**
+ * enum iwl_tpt_counter - always-on throughput counters
+ * @IWL_TPT_RX_POLLS: RX NAPI polls
+ * @IWL_TPT_RX_RBS: receive buffers handled
+ * @IWL_TPT_RB_REFILL_MISS: receive buffer allocations that failed
+ * @IWL_TPT_TX_FRAMES: data frames put on a TFD ring
+ * @IWL_TPT_TX_RECLAIMED: data frames reclaimed after transmission
+ * @IWL_TPT_TX_STOPS: times a data queue was stopped for lack of room
+ * @IWL_TPT_NUM_COUNTERS: number of counters
+ */
+enum iwl_tpt_counter {
+	IWL_TPT_RX_POLLS,
+	IWL_TPT_RX_RBS,
+	IWL_TPT_RB_REFILL_MISS,
+	IWL_TPT_TX_FRAMES,
+	IWL_TPT_TX_RECLAIMED,
+	IWL_TPT_TX_STOPS,
+	IWL_TPT_NUM_COUNTERS,
+};
+
+/**
+ * enum iwl_tpt_hist - always-on log2 histograms
+ * @IWL_TPT_HIST_RX_POLL_NS: time spent handling one RX NAPI poll
+ * @IWL_TPT_HIST_TX_LATENCY_US: time from putting a data frame on the
+ *	ring until it is reclaimed
+ * @IWL_TPT_HIST_REORDER_HOLD_US: time a frame was held in the reorder
+ *	buffer (jiffies resolution)
+ * @IWL_TPT_HIST_TFD_USED: used TFDs of a data queue when a frame is added
+ * @IWL_TPT_NUM_HISTS: number of histograms
+ */
+enum iwl_tpt_hist {
+	IWL_TPT_HIST_RX_POLL_NS,
+	IWL_TPT_HIST_TX_LATENCY_US,
+	IWL_TPT_HIST_REORDER_HOLD_US,
+	IWL_TPT_HIST_TFD_USED,
+	IWL_TPT_NUM_HISTS,
+};
+
+#define IWL_TPT_HIST_BUCKETS	32
+
+/**
+ * struct iwl_tpt_stats - per-CPU throughput statistics
+ * @counters: see &enum iwl_tpt_counter
+ * @hist: see &enum iwl_tpt_hist; bucket 0 counts zero values, bucket n
+ *	counts values in [2^(n-1), 2^n), the last bucket everything above
+ */
+struct iwl_tpt_stats {
+	u64 counters[IWL_TPT_NUM_COUNTERS];
+	u64 hist[IWL_TPT_NUM_HISTS][IWL_TPT_HIST_BUCKETS];
 };
 
 /**
@@ -974,6 +1048,7 @@ struct iwl_trans_txqs {
  *	This mode is set dynamically, depending on the WoWLAN values
  *	configured from the userspace at runtime.
  * @iwl_trans_txqs: transport tx queues data.
+ * @tpt: per-CPU throughput and latency statistics, see &struct iwl_tpt_stats
  */
 struct iwl_trans {
 	bool csme_own;
@@ -1036,6 +1111,8 @@ struct iwl_trans {
 	const char *name;
 	struct iwl_trans_txqs txqs;
 
+	struct iwl_tpt_stats __percpu *tpt;
+
 	/* pointer to trans specific struct */
 	/*Ensure that this pointer will always be aligned to sizeof pointer */
 	char trans_specific[] __aligned(sizeof(void *));
@@ -1044,6 +1121,29 @@ struct iwl_trans {
 const char *iwl_get_cmd_string(struct iwl_trans *trans, u32 id);
 int iwl_cmd_groups_verify_sorted(const struct iwl_trans_config *trans);
 
+static inline void iwl_trans_tpt_add(struct iwl_trans *trans,
+				     enum iwl_tpt_counter counter, u64 val)
+{
+	this_cpu_add(trans->tpt->counters[counter], val);
+}
+
+static inline void iwl_trans_tpt_inc(struct iwl_trans *trans,
+				     enum iwl_tpt_counter counter)
+{
+	this_cpu_inc(trans->tpt->counters[counter]);
+}
+
+static inline void iwl_trans_tpt_hist(struct iwl_trans *trans,
+				      enum iwl_tpt_hist hist, u64 val)
+{
+	unsigned int bucket = min_t(unsigned int, fls64(val),
+				    IWL_TPT_HIST_BUCKETS - 1);
+
+	this_cpu_inc(trans->tpt->hist[hist][bucket]);
+}
+
+void iwl_trans_tpt_sum(struct iwl_trans *trans, struct iwl_tpt_stats *sum);
+
 static inline void iwl_trans_configure(struct iwl_trans *trans,
 				       const struct iwl_trans_config *trans_cfg)
 {
@@ -77,6 +77,7 @@
 #define IWL_MVM_RS_STAY_IN_COLUMN_TIMEOUT	5	/* Seconds */
 #define IWL_MVM_RS_IDLE_TIMEOUT			5	/* Seconds */
 #define IWL_MVM_RS_MISSED_RATE_MAX		15
+#define IWL_MVM_RS_SUCCESS_BATCH		8
 #define IWL_MVM_RS_LEGACY_FAILURE_LIMIT		160
 #define IWL_MVM_RS_LEGACY_SUCCESS_LIMIT		480
 #define IWL_MVM_RS_LEGACY_TABLE_COUNT		160
@@ -185,6 +186,7 @@
 #define IWL_MVM_RS_STAY_IN_COLUMN_TIMEOUT       (mvm->trans->dbg_cfg.MVM_RS_STAY_IN_COLUMN_TIMEOUT)
 #define IWL_MVM_RS_IDLE_TIMEOUT                 (mvm->trans->dbg_cfg.MVM_RS_IDLE_TIMEOUT)
 #define IWL_MVM_RS_MISSED_RATE_MAX		(mvm->trans->dbg_cfg.MVM_RS_MISSED_RATE_MAX)
+#define IWL_MVM_RS_SUCCESS_BATCH		(mvm->trans->dbg_cfg.MVM_RS_SUCCESS_BATCH)
 #define IWL_MVM_RS_LEGACY_FAILURE_LIMIT		(mvm->trans->dbg_cfg.MVM_RS_LEGACY_FAILURE_LIMIT)
 #define IWL_MVM_RS_LEGACY_SUCCESS_LIMIT		(mvm->trans->dbg_cfg.MVM_RS_LEGACY_SUCCESS_LIMIT)
 #define IWL_MVM_RS_LEGACY_TABLE_COUNT		(mvm->trans->dbg_cfg.MVM_RS_LEGACY_TABLE_COUNT)
@@ -1656,15 +1656,16 @@ static void iwl_mvm_d3_update_keys(struct ieee80211_hw *hw,
 	data->num_keys++;
 
 	/*
-	 * pairwise key - update sequence counters only;
-	 * note that this assumes no TDLS sessions are active
+	 * pairwise key - update sequence counters only, in the same pass
+	 * that looks for the GTK; note that this assumes no TDLS sessions
+	 * are active
 	 */
 	if (sta) {
 		struct ieee80211_key_seq seq = {};
 		union iwl_all_tsc_rsc *sc =
 			&data->status->gtk[0].rsc.all_tsc_rsc;
 
-		if (data->find_phase)
+		if (!data->find_phase)
 			return;
 
 		switch (key->cipher) {
@@ -1694,10 +1695,8 @@ static void iwl_mvm_d3_update_keys(struct ieee80211_hw *hw,
 		return;
 	}
 
-	if (data->status->num_of_gtk_rekeys)
-		ieee80211_remove_key(key);
-	else if (data->last_gtk == key)
-		iwl_mvm_set_key_rx_seq(data->mvm, key, data->status);
+	/* only iterated again if the firmware installed a new GTK */
+	ieee80211_remove_key(key);
 }
 
 static bool iwl_mvm_setup_connection_keep(struct iwl_mvm *mvm,
@@ -1719,7 +1718,10 @@ static bool iwl_mvm_setup_connection_keep(struct iwl_mvm *mvm,
 	if (le32_to_cpu(status->wakeup_reasons) & disconnection_reasons)
 		return false;
 
-	/* find last GTK that we used initially, if any */
+	/*
+	 * find last GTK that we used initially, if any, and restore the
+	 * pairwise sequence counters on the way
+	 */
 	gtkdata.find_phase = true;
 	ieee80211_iter_keys(mvm->hw, vif,
 			    iwl_mvm_d3_update_keys, &gtkdata);
@@ -1731,14 +1733,6 @@ static bool iwl_mvm_setup_connection_keep(struct iwl_mvm *mvm,
 	if (!gtkdata.last_gtk)
 		return false;
 
-	/*
-	 * invalidate all other GTKs that might still exist and update
-	 * the one that we used
-	 */
-	gtkdata.find_phase = false;
-	ieee80211_iter_keys(mvm->hw, vif,
-			    iwl_mvm_d3_update_keys, &gtkdata);
-
 	IWL_DEBUG_WOWLAN(mvm, "num of GTK rekeying %d\n",
 			 le32_to_cpu(status->num_of_gtk_rekeys));
 	if (status->num_of_gtk_rekeys) {
@@ -1753,6 +1747,11 @@ static bool iwl_mvm_setup_connection_keep(struct iwl_mvm *mvm,
 		};
 		__be64 replay_ctr;
 
+		/* invalidate all the GTKs we had, the firmware rekeyed */
+		gtkdata.find_phase = false;
+		ieee80211_iter_keys(mvm->hw, vif,
+				    iwl_mvm_d3_update_keys, &gtkdata);
+
 		IWL_DEBUG_WOWLAN(mvm,
 				 "Received from FW GTK cipher %d, key index %d\n",
 				 conf.conf.cipher, conf.conf.keyidx);
@@ -1792,6 +1791,9 @@ static bool iwl_mvm_setup_connection_keep(struct iwl_mvm *mvm,
 
 		ieee80211_gtk_rekey_notify(vif, vif->bss_conf.bssid,
 					   (void *)&replay_ctr, GFP_KERNEL);
+	} else {
+		/* the GTK we used is still valid, only update its counters */
+		iwl_mvm_set_key_rx_seq(mvm, gtkdata.last_gtk, status);
 	}
 
 out:
@@ -1971,9 +1973,13 @@ iwl_mvm_get_wakeup_status(struct iwl_mvm *mvm, u8 sta_id)
 	u32 cmd_size = cmd_ver != IWL_FW_CMD_VER_UNKNOWN ? sizeof(station_id) : 0;
 
 	if (!mvm->net_detect) {
-		/* only for tracing for now */
-		int ret = iwl_mvm_send_cmd_pdu(mvm, OFFLOADS_QUERY_CMD, 0,
-					       cmd_size, &station_id);
+		/*
+		 * only for tracing for now, so don't wait for the response
+		 * and let it overlap with the status query below
+		 */
+		int ret = iwl_mvm_send_cmd_pdu(mvm, OFFLOADS_QUERY_CMD,
+					       CMD_ASYNC, cmd_size,
+					       &station_id);
 		if (ret)
 			IWL_ERR(mvm, "failed to query offload statistics (%d)\n", ret);
 	}
@@ -1991,8 +1997,10 @@ static bool iwl_mvm_query_wakeup_reasons(struct iwl_mvm *mvm,
 	int i;
 	bool keep;
 	struct iwl_mvm_sta *mvm_ap_sta;
+	ktime_t start = ktime_get();
 
 	fw_status = iwl_mvm_get_wakeup_status(mvm, mvmvif->ap_sta_id);
+	mvm->resume_stats.fw_status_us = ktime_us_delta(ktime_get(), start);
 	if (IS_ERR_OR_NULL(fw_status))
 		goto out_unlock;
 
@@ -2034,7 +2042,9 @@ static bool iwl_mvm_query_wakeup_reasons(struct iwl_mvm *mvm,
 
 	iwl_mvm_report_wakeup_reasons(mvm, vif, &status);
 
+	start = ktime_get();
 	keep = iwl_mvm_setup_connection_keep(mvm, vif, fw_status);
+	mvm->resume_stats.keys_us = ktime_us_delta(ktime_get(), start);
 
 	kfree(fw_status);
 	return keep;
@@ -2305,8 +2315,22 @@ static bool iwl_mvm_check_rt_status(struct iwl_mvm *mvm,
 	return false;
 }
 
+static void iwl_mvm_resume_stats_done(struct iwl_mvm *mvm, ktime_t start,
+				      bool keep, bool restart)
+{
+	struct iwl_mvm_resume_stats *stats = &mvm->resume_stats;
+
+	stats->total_us = ktime_us_delta(ktime_get(), start);
+	stats->max_us = max(stats->max_us, stats->total_us);
+	if (keep)
+		stats->kept++;
+	if (restart)
+		stats->restarts++;
+}
+
 static int __iwl_mvm_resume(struct iwl_mvm *mvm, bool test)
 {
+	struct iwl_mvm_resume_stats *stats = &mvm->resume_stats;
 	struct ieee80211_vif *vif = NULL;
 	int ret = 1;
 	enum iwl_d3_status d3_status;
@@ -2315,9 +2339,17 @@ static int __iwl_mvm_resume(struct iwl_mvm *mvm, bool test)
 					 IWL_UCODE_TLV_CAPA_CNSLDTD_D3_D0_IMG);
 	bool d0i3_first = fw_has_capa(&mvm->fw->ucode_capa,
 				      IWL_UCODE_TLV_CAPA_D0I3_END_FIRST);
+	ktime_t start = ktime_get(), t;
 
 	mutex_lock(&mvm->mutex);
 
+	stats->count++;
+	stats->rt_check_us = 0;
+	stats->d3_resume_us = 0;
+	stats->d0i3_end_us = 0;
+	stats->fw_status_us = 0;
+	stats->keys_us = 0;
+
 #ifdef CPTCFG_IWLWIFI_WIFI_6_SUPPORT
 	mvm->last_reset_or_resume_time_jiffies = jiffies;
 #endif /* CPTCFG_IWLWIFI_WIFI_6_SUPPORT */
@@ -2329,6 +2361,7 @@ static int __iwl_mvm_resume(struct iwl_mvm *mvm, bool test)
 
 	iwl_fw_dbg_read_d3_debug_data(&mvm->fwrt);
 
+	t = ktime_get();
 	if (iwl_mvm_check_rt_status(mvm, vif)) {
 		set_bit(STATUS_FW_ERROR, &mvm->trans->status);
 		iwl_mvm_dump_nic_error_log(mvm);
@@ -2339,8 +2372,11 @@ static int __iwl_mvm_resume(struct iwl_mvm *mvm, bool test)
 		ret = 1;
 		goto err;
 	}
+	stats->rt_check_us = ktime_us_delta(ktime_get(), t);
 
+	t = ktime_get();
 	ret = iwl_trans_d3_resume(mvm->trans, &d3_status, test, !unified_image);
+	stats->d3_resume_us = ktime_us_delta(ktime_get(), t);
 	if (ret)
 		goto err;
 
@@ -2356,7 +2392,9 @@ static int __iwl_mvm_resume(struct iwl_mvm *mvm, bool test)
 		};
 		int len;
 
+		t = ktime_get();
 		ret = iwl_mvm_send_cmd(mvm, &cmd);
+		stats->d0i3_end_us = ktime_us_delta(ktime_get(), t);
 		if (ret < 0) {
 			IWL_ERR(mvm, "Failed to send D0I3_END_CMD first (%d)\n",
 				ret);
@@ -2441,12 +2479,18 @@ out:
 	/* no need to reset the device in unified images, if successful */
 	if (unified_image && !ret) {
 		/* nothing else to do if we already sent D0I3_END_CMD */
-		if (d0i3_first)
+		if (d0i3_first) {
+			iwl_mvm_resume_stats_done(mvm, start, keep, false);
 			return 0;
+		}
 
+		t = ktime_get();
 		ret = iwl_mvm_send_cmd_pdu(mvm, D0I3_END_CMD, 0, 0, NULL);
-		if (!ret)
+		stats->d0i3_end_us = ktime_us_delta(ktime_get(), t);
+		if (!ret) {
+			iwl_mvm_resume_stats_done(mvm, start, keep, false);
 			return 0;
+		}
 	}
 
 	/*
@@ -2459,6 +2503,8 @@ out:
 	/* regardless of what happened, we're now out of D3 */
 	mvm->trans->system_pm_mode = IWL_PLAT_PM_MODE_DISABLED;
 
+	iwl_mvm_resume_stats_done(mvm, start, keep, true);
+
 	return 1;
 }
 
@@ -369,6 +369,42 @@ static ssize_t iwl_dbgfs_nic_temp_read(struct file *file,
 	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
 }
 
+static ssize_t iwl_dbgfs_tt_stats_read(struct file *file,
+				       char __user *user_buf,
+				       size_t count, loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	struct iwl_mvm_tt_mgmt *tt = &mvm->thermal_throttle;
+	struct iwl_mvm_tt_stats stats;
+	char buf[320];
+	int pos = 0;
+
+	mutex_lock(&mvm->mutex);
+	iwl_mvm_tt_stats_update(mvm);
+	stats = tt->stats;
+	mutex_unlock(&mvm->mutex);
+
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "predictive: %d\n", tt->predictive);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "tx_backoff: %u us (min %u us)\n",
+			 tt->tx_backoff, tt->min_backoff);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "slope: %d mC/s, integral: %d mC*s\n",
+			 tt->trend.slope, tt->trend.integral);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "backoff_time: %llu ms\n", stats.backoff_ms);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "est_airtime_lost: %llu ms\n", stats.lost_ms);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "ctdp_time: %llu ms\n", stats.ctdp_ms);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "backoff_changes: %u (early %u)\n",
+			 stats.changes, stats.early);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+
 #ifdef CONFIG_ACPI
 static ssize_t iwl_dbgfs_sar_geo_profile_read(struct file *file,
 					      char __user *user_buf,
@@ -1122,6 +1158,271 @@ static ssize_t iwl_dbgfs_drv_rx_stats_read(struct file *file,
 					  &mvm->drv_rx_stats);
 }
 
+static ssize_t iwl_dbgfs_rss_config_read(struct file *file,
+					 char __user *user_buf, size_t count,
+					 loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	size_t bufsz = 2 * sizeof(mvm->rss.key) +
+		       3 * IWL_RSS_INDIRECTION_TABLE_SIZE + 32;
+	int pos = 0, i;
+	ssize_t ret;
+	char *buf;
+
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	mutex_lock(&mvm->mutex);
+	if (mvm->rss.valid) {
+		pos += scnprintf(buf + pos, bufsz - pos, "key=%*phN\nindir=",
+				 (int)sizeof(mvm->rss.key), mvm->rss.key);
+		for (i = 0; i < IWL_RSS_INDIRECTION_TABLE_SIZE; i++)
+			pos += scnprintf(buf + pos, bufsz - pos, "%s%u",
+					 i ? " " : "", mvm->rss.indir[i]);
+		pos += scnprintf(buf + pos, bufsz - pos, "\n");
+	}
+	mutex_unlock(&mvm->mutex);
+
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+
+	return ret;
+}
+
+/*
+ * "key=<hex>" replaces the RSS secret key, "indir=<q> <q> ..." fills the
+ * indirection table by repeating the given RX queues.
+ */
+static ssize_t iwl_dbgfs_rss_config_write(struct iwl_mvm *mvm, char *buf,
+					  size_t count, loff_t *ppos)
+{
+	u8 queues[IWL_RSS_INDIRECTION_TABLE_SIZE];
+	struct iwl_mvm_rss_cfg rss;
+	int ret = 0, n = 0, i;
+
+	if (!iwl_mvm_has_new_rx_api(mvm) || mvm->trans->num_rx_queues == 1)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&mvm->mutex);
+	if (!mvm->rss.valid) {
+		ret = -EIO;
+		goto out;
+	}
+	rss = mvm->rss;
+
+	if (!strncmp(buf, "key=", 4)) {
+		char *hex = strim(buf + 4);
+
+		if (strlen(hex) != 2 * sizeof(rss.key) ||
+		    hex2bin((u8 *)rss.key, hex, sizeof(rss.key))) {
+			ret = -EINVAL;
+			goto out;
+		}
+	} else if (!strncmp(buf, "indir=", 6)) {
+		char *pos = buf + 6, *tok;
+
+		while ((tok = strsep(&pos, " ,\n"))) {
+			u8 q;
+
+			if (!*tok)
+				continue;
+			/* queue 0 is the fallback queue, keep RSS off it */
+			if (n == ARRAY_SIZE(queues) || kstrtou8(tok, 0, &q) ||
+			    !q || q >= mvm->trans->num_rx_queues) {
+				ret = -EINVAL;
+				goto out;
+			}
+			queues[n++] = q;
+		}
+		if (!n) {
+			ret = -EINVAL;
+			goto out;
+		}
+		for (i = 0; i < ARRAY_SIZE(rss.indir); i++)
+			rss.indir[i] = queues[i % n];
+	} else {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	mvm->rss = rss;
+	if (iwl_mvm_firmware_running(mvm))
+		ret = iwl_send_rss_cfg_cmd(mvm);
+out:
+	mutex_unlock(&mvm->mutex);
+
+	return ret ?: count;
+}
+
+static ssize_t iwl_dbgfs_restart_stats_read(struct file *file,
+					    char __user *user_buf, size_t count,
+					    loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	struct iwl_mvm_restart_stats stats;
+	char buf[256];
+	int pos = 0;
+
+	mutex_lock(&mvm->mutex);
+	stats = mvm->restart_stats;
+	mutex_unlock(&mvm->mutex);
+
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "restarts: %u (fast %u, failed %u)\n",
+			 stats.count, stats.fast, stats.failed);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "last: load %u us, up %u us, reconfig %u us, total %u us\n",
+			 stats.load_us, stats.up_us, stats.reconfig_us,
+			 stats.total_us);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos, "max: %u us\n",
+			 stats.max_us);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+
+static ssize_t iwl_dbgfs_scan_stats_read(struct file *file,
+					 char __user *user_buf, size_t count,
+					 loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	struct iwl_mvm_scan_stats stats;
+	int i, empty = 0, seen = 0;
+	char buf[256];
+	int pos = 0;
+
+	mutex_lock(&mvm->mutex);
+	stats = mvm->scan_stats;
+	for (i = 0; i < IWL_SCAN_NUM_CHANNELS; i++) {
+		if (mvm->scan_hist.last_seen[i])
+			seen++;
+		if (mvm->scan_hist.empty_scans[i])
+			empty++;
+	}
+	mutex_unlock(&mvm->mutex);
+
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "scans: %u (aborted %u, short dwell %u, reordered %u)\n",
+			 stats.count, stats.aborted, stats.short_dwell,
+			 stats.reordered);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "duration: last %u us, avg %u us, max %u us\n",
+			 stats.last_us, stats.avg_us, stats.max_us);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "channels: %d with BSS seen, %d currently empty\n",
+			 seen, empty);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+
+static ssize_t iwl_dbgfs_conn_stats_read(struct file *file,
+					 char __user *user_buf, size_t count,
+					 loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	struct iwl_mvm_cmd_batch_stats batch;
+	struct iwl_mvm_conn_stats conn;
+	char buf[256];
+	int pos = 0;
+
+	mutex_lock(&mvm->mutex);
+	conn = mvm->conn_stats;
+	batch = mvm->cmd_batch_stats;
+	mutex_unlock(&mvm->mutex);
+
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "connections: %u\n", conn.count);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "last: %u us (driver %u us)\n",
+			 conn.last_us, conn.last_drv_us);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "driver: avg %u us, max %u us\n",
+			 conn.avg_drv_us, conn.max_drv_us);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "cmd batches: %u (%u cmds), last %u us, max %u us\n",
+			 batch.batches, batch.cmds, batch.last_us,
+			 batch.max_us);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+
+#ifdef CONFIG_PM_SLEEP
+static ssize_t iwl_dbgfs_resume_stats_read(struct file *file,
+					   char __user *user_buf, size_t count,
+					   loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	struct iwl_mvm_resume_stats stats;
+	char buf[320];
+	int pos = 0;
+
+	mutex_lock(&mvm->mutex);
+	stats = mvm->resume_stats;
+	mutex_unlock(&mvm->mutex);
+
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "resumes: %u (kept %u, restarts %u)\n",
+			 stats.count, stats.kept, stats.restarts);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "last: rt_check %u us, d3_resume %u us, d0i3_end %u us\n",
+			 stats.rt_check_us, stats.d3_resume_us,
+			 stats.d0i3_end_us);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "last: fw_status %u us, keys %u us, total %u us\n",
+			 stats.fw_status_us, stats.keys_us, stats.total_us);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos, "max: %u us\n",
+			 stats.max_us);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+#endif
+
+static ssize_t iwl_dbgfs_reorder_stats_read(struct file *file,
+					   char __user *user_buf, size_t count,
+					   loff_t *ppos)
+{
+	struct iwl_mvm *mvm = file->private_data;
+	int i, q, pos = 0;
+	size_t bufsz = IWL_MAX_BAID * 128 + 1;
+	char *buf;
+	ssize_t ret;
+
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	rcu_read_lock();
+	for (i = 0; i < IWL_MAX_BAID; i++) {
+		struct iwl_mvm_baid_data *data;
+		struct iwl_mvm_reorder_stats stats = {};
+
+		data = rcu_dereference(mvm->baid_map[i]);
+		if (!data)
+			continue;
+
+		for (q = 0; q < mvm->trans->num_rx_queues; q++) {
+			struct iwl_mvm_reorder_buffer *buffer =
+				&data->reorder_buf[q];
+
+			stats.holes += READ_ONCE(buffer->stats.holes);
+			stats.timeouts += READ_ONCE(buffer->stats.timeouts);
+			stats.released += READ_ONCE(buffer->stats.released);
+			stats.dropped += READ_ONCE(buffer->stats.dropped);
+		}
+
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "baid %d sta %d tid %d: holes %u timeouts %u released %u dropped %u\n",
+				 i, data->sta_id, data->tid, stats.holes,
+				 stats.timeouts, stats.released, stats.dropped);
+	}
+	rcu_read_unlock();
+
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+
+	return ret;
+}
+
 static ssize_t iwl_dbgfs_fw_restart_write(struct iwl_mvm *mvm, char *buf,
 					  size_t count, loff_t *ppos)
 {
@@ -2260,6 +2561,7 @@ MVM_DEBUGFS_WRITE_FILE_OPS(send_echo_cmd, 8);
 MVM_DEBUGFS_READ_WRITE_FILE_OPS(sram, 64);
 MVM_DEBUGFS_READ_WRITE_FILE_OPS(set_nic_temperature, 64);
 MVM_DEBUGFS_READ_FILE_OPS(nic_temp);
+MVM_DEBUGFS_READ_FILE_OPS(tt_stats);
 MVM_DEBUGFS_READ_FILE_OPS(stations);
 MVM_DEBUGFS_READ_FILE_OPS(rs_data);
 MVM_DEBUGFS_READ_FILE_OPS(bt_notif);
@@ -2267,6 +2569,14 @@ MVM_DEBUGFS_READ_FILE_OPS(bt_cmd);
 MVM_DEBUGFS_READ_WRITE_FILE_OPS(disable_power_off, 64);
 MVM_DEBUGFS_READ_FILE_OPS(fw_rx_stats);
 MVM_DEBUGFS_READ_FILE_OPS(drv_rx_stats);
+MVM_DEBUGFS_READ_FILE_OPS(reorder_stats);
+MVM_DEBUGFS_READ_FILE_OPS(restart_stats);
+MVM_DEBUGFS_READ_FILE_OPS(scan_stats);
+MVM_DEBUGFS_READ_FILE_OPS(conn_stats);
+#ifdef CONFIG_PM_SLEEP
+MVM_DEBUGFS_READ_FILE_OPS(resume_stats);
+#endif
+MVM_DEBUGFS_READ_WRITE_FILE_OPS(rss_config, 128);
 MVM_DEBUGFS_READ_FILE_OPS(fw_ver);
 MVM_DEBUGFS_READ_FILE_OPS(phy_integration_ver);
 MVM_DEBUGFS_WRITE_FILE_OPS(fw_restart, 10);
@@ -2481,6 +2791,9 @@ void iwl_mvm_dbgfs_register(struct iwl_mvm *mvm)
 	MVM_DEBUGFS_ADD_FILE(sram, mvm->debugfs_dir, 0600);
 	MVM_DEBUGFS_ADD_FILE(set_nic_temperature, mvm->debugfs_dir, 0600);
 	MVM_DEBUGFS_ADD_FILE(nic_temp, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(tt_stats, mvm->debugfs_dir, 0400);
+	debugfs_create_bool("tt_predictive", 0600, mvm->debugfs_dir,
+			    &mvm->thermal_throttle.predictive);
 	MVM_DEBUGFS_ADD_FILE(ctdp_budget, mvm->debugfs_dir, 0400);
 	MVM_DEBUGFS_ADD_FILE(stop_ctdp, mvm->debugfs_dir, 0200);
 	MVM_DEBUGFS_ADD_FILE(force_ctkill, mvm->debugfs_dir, 0200);
@@ -2491,6 +2804,11 @@ void iwl_mvm_dbgfs_register(struct iwl_mvm *mvm)
 	MVM_DEBUGFS_ADD_FILE(fw_ver, mvm->debugfs_dir, 0400);
 	MVM_DEBUGFS_ADD_FILE(fw_rx_stats, mvm->debugfs_dir, 0400);
 	MVM_DEBUGFS_ADD_FILE(drv_rx_stats, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(reorder_stats, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(restart_stats, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(scan_stats, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(conn_stats, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(rss_config, mvm->debugfs_dir, 0600);
 	MVM_DEBUGFS_ADD_FILE(fw_restart, mvm->debugfs_dir, 0200);
 	MVM_DEBUGFS_ADD_FILE(fw_nmi, mvm->debugfs_dir, 0200);
 	MVM_DEBUGFS_ADD_FILE(bt_tx_prio, mvm->debugfs_dir, 0200);
@@ -2565,6 +2883,7 @@ void iwl_mvm_dbgfs_register(struct iwl_mvm *mvm)
 
 #ifdef CONFIG_PM_SLEEP
 	MVM_DEBUGFS_ADD_FILE(d3_test, mvm->debugfs_dir, 0400);
+	MVM_DEBUGFS_ADD_FILE(resume_stats, mvm->debugfs_dir, 0400);
 	debugfs_create_bool("d3_wake_sysassert", 0600, mvm->debugfs_dir,
 			    &mvm->d3_wake_sysassert);
 	debugfs_create_u32("last_netdetect_scans", 0400, mvm->debugfs_dir,
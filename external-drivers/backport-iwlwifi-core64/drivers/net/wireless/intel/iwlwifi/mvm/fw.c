@@ -52,7 +52,7 @@ static int iwl_send_tx_ant_cfg(struct iwl_mvm *mvm, u8 valid_tx_ant)
 				    sizeof(tx_ant_cmd), &tx_ant_cmd);
 }
 
-static int iwl_send_rss_cfg_cmd(struct iwl_mvm *mvm)
+int iwl_send_rss_cfg_cmd(struct iwl_mvm *mvm)
 {
 	int i;
 	struct iwl_rss_config_cmd cmd = {
@@ -68,11 +68,24 @@ static int iwl_send_rss_cfg_cmd(struct iwl_mvm *mvm)
 	if (mvm->trans->num_rx_queues == 1)
 		return 0;
 
-	/* Do not direct RSS traffic to Q 0 which is our fallback queue */
-	for (i = 0; i < ARRAY_SIZE(cmd.indirection_table); i++)
-		cmd.indirection_table[i] =
-			1 + (i % (mvm->trans->num_rx_queues - 1));
-	netdev_rss_key_fill(cmd.secret_key, sizeof(cmd.secret_key));
+	/*
+	 * Keep the configuration across firmware restarts so that a key or
+	 * table set through debugfs stays in effect.
+	 */
+	if (!mvm->rss.valid) {
+		/* Do not direct RSS traffic to Q 0 which is our fallback queue */
+		for (i = 0; i < ARRAY_SIZE(mvm->rss.indir); i++)
+			mvm->rss.indir[i] =
+				1 + (i % (mvm->trans->num_rx_queues - 1));
+		netdev_rss_key_fill(mvm->rss.key, sizeof(mvm->rss.key));
+		mvm->rss.valid = true;
+	}
+
+	BUILD_BUG_ON(sizeof(cmd.secret_key) != sizeof(mvm->rss.key));
+	BUILD_BUG_ON(sizeof(cmd.indirection_table) != sizeof(mvm->rss.indir));
+	memcpy(cmd.secret_key, mvm->rss.key, sizeof(cmd.secret_key));
+	memcpy(cmd.indirection_table, mvm->rss.indir,
+	       sizeof(cmd.indirection_table));
 
 	return iwl_mvm_send_cmd_pdu(mvm, RSS_CONFIG_CMD, 0, sizeof(cmd), &cmd);
 }
@@ -1501,6 +1514,36 @@ static int iwl_mvm_sar_init(struct iwl_mvm *mvm)
 	return iwl_mvm_sar_select_profile(mvm, 1, 1);
 }
 
+/*
+ * The INIT image only produces the NVM and the PHY DB calibration results,
+ * both of which survive a firmware restart, so go straight to the runtime
+ * image unless an external NVM file has to be pushed to the NIC again.
+ */
+static bool iwl_mvm_can_skip_init(struct iwl_mvm *mvm)
+{
+	return iwlmvm_mod_params.fast_restart &&
+	       test_bit(IWL_MVM_STATUS_IN_HW_RESTART, &mvm->status) &&
+	       mvm->nvm_data && !mvm->nvm_file_name &&
+	       iwl_phy_db_is_valid(mvm->phy_db);
+}
+
+static int iwl_mvm_load_regular_fw(struct iwl_mvm *mvm)
+{
+	int ret;
+
+	mvm->rfkill_safe_init_done = false;
+	ret = iwl_mvm_load_ucode_wait_alive(mvm, IWL_UCODE_REGULAR);
+	if (ret)
+		return ret;
+
+	mvm->rfkill_safe_init_done = true;
+
+	iwl_dbg_tlv_time_point(&mvm->fwrt, IWL_FW_INI_TIME_POINT_AFTER_ALIVE,
+			       NULL);
+
+	return iwl_init_paging(&mvm->fwrt, mvm->fwrt.cur_fw_img);
+}
+
 static int iwl_mvm_load_rt_fw(struct iwl_mvm *mvm)
 {
 	int ret;
@@ -1508,6 +1551,23 @@ static int iwl_mvm_load_rt_fw(struct iwl_mvm *mvm)
 	if (iwl_mvm_has_unified_ucode(mvm))
 		return iwl_run_unified_mvm_ucode(mvm);
 
+	if (iwl_mvm_can_skip_init(mvm)) {
+		IWL_DEBUG_INFO(mvm, "Restart: reusing PHY DB, skipping INIT\n");
+		ret = iwl_mvm_load_regular_fw(mvm);
+		if (!ret) {
+			mvm->restart_stats.fast++;
+			return 0;
+		}
+
+		IWL_ERR(mvm, "Fast restart failed (%d), running INIT ucode\n",
+			ret);
+		iwl_fw_dbg_stop_sync(&mvm->fwrt);
+		iwl_trans_stop_device(mvm->trans);
+		ret = iwl_trans_start_hw(mvm->trans);
+		if (ret)
+			return ret;
+	}
+
 	ret = iwl_run_init_mvm_ucode(mvm);
 
 	if (ret) {
@@ -1524,17 +1584,7 @@ static int iwl_mvm_load_rt_fw(struct iwl_mvm *mvm)
 	if (ret)
 		return ret;
 
-	mvm->rfkill_safe_init_done = false;
-	ret = iwl_mvm_load_ucode_wait_alive(mvm, IWL_UCODE_REGULAR);
-	if (ret)
-		return ret;
-
-	mvm->rfkill_safe_init_done = true;
-
-	iwl_dbg_tlv_time_point(&mvm->fwrt, IWL_FW_INI_TIME_POINT_AFTER_ALIVE,
-			       NULL);
-
-	return iwl_init_paging(&mvm->fwrt, mvm->fwrt.cur_fw_img);
+	return iwl_mvm_load_regular_fw(mvm);
 }
 
 int iwl_mvm_up(struct iwl_mvm *mvm)
@@ -1543,6 +1593,8 @@ int iwl_mvm_up(struct iwl_mvm *mvm)
 	struct ieee80211_channel *chan;
 	struct cfg80211_chan_def chandef;
 	struct ieee80211_supported_band *sband = NULL;
+	bool restart = test_bit(IWL_MVM_STATUS_IN_HW_RESTART, &mvm->status);
+	ktime_t start = ktime_get(), loaded;
 
 	lockdep_assert_held(&mvm->mutex);
 
@@ -1559,6 +1611,10 @@ int iwl_mvm_up(struct iwl_mvm *mvm)
 		goto error;
 	}
 
+	loaded = ktime_get();
+	if (restart)
+		mvm->restart_stats.load_us = ktime_us_delta(loaded, start);
+
 	iwl_get_shared_mem_conf(&mvm->fwrt);
 
 	ret = iwl_mvm_sf_update(mvm, NULL, false);
@@ -1808,6 +1864,12 @@ int iwl_mvm_up(struct iwl_mvm *mvm)
 			iwl_rfi_send_config_cmd(mvm, NULL);
 	}
 
+	if (restart) {
+		mvm->restart_stats.up_done = ktime_get();
+		mvm->restart_stats.up_us =
+			ktime_us_delta(mvm->restart_stats.up_done, loaded);
+	}
+
 	IWL_DEBUG_INFO(mvm, "RT uCode started.\n");
 	return 0;
  error:
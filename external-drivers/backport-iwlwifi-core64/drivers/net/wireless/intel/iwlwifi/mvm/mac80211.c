@@ -1226,6 +1226,7 @@ int __iwl_mvm_mac_start(struct iwl_mvm *mvm)
 		 */
 		set_bit(IWL_MVM_STATUS_IN_HW_RESTART, &mvm->status);
 		clear_bit(IWL_MVM_STATUS_HW_RESTART_REQUESTED, &mvm->status);
+		mvm->restart_stats.start = ktime_get();
 		/* Clean up some internal and mac80211 state on restart */
 		iwl_mvm_restart_cleanup(mvm);
 	}
@@ -1246,6 +1247,8 @@ int __iwl_mvm_mac_start(struct iwl_mvm *mvm)
 		 * would do.
 		 */
 		clear_bit(IWL_MVM_STATUS_IN_HW_RESTART, &mvm->status);
+		mvm->restart_stats.failed++;
+		mvm->restart_stats.start = 0;
 	}
 
 	return ret;
@@ -1265,6 +1268,25 @@ static int iwl_mvm_mac_start(struct ieee80211_hw *hw)
 	return ret;
 }
 
+static void iwl_mvm_restart_stats_done(struct iwl_mvm *mvm)
+{
+	struct iwl_mvm_restart_stats *stats = &mvm->restart_stats;
+	ktime_t now = ktime_get();
+
+	if (!stats->start)
+		return;
+
+	stats->reconfig_us = ktime_us_delta(now, stats->up_done);
+	stats->total_us = ktime_us_delta(now, stats->start);
+	stats->max_us = max(stats->max_us, stats->total_us);
+	stats->count++;
+	stats->start = 0;
+
+	IWL_DEBUG_INFO(mvm, "Restart done in %u us (load %u up %u reconfig %u)\n",
+		       stats->total_us, stats->load_us, stats->up_us,
+		       stats->reconfig_us);
+}
+
 static void iwl_mvm_restart_complete(struct iwl_mvm *mvm)
 {
 	int ret;
@@ -1272,6 +1294,7 @@ static void iwl_mvm_restart_complete(struct iwl_mvm *mvm)
 	mutex_lock(&mvm->mutex);
 
 	clear_bit(IWL_MVM_STATUS_IN_HW_RESTART, &mvm->status);
+	iwl_mvm_restart_stats_done(mvm);
 
 	ret = iwl_mvm_update_quotas(mvm, true, NULL);
 	if (ret)
@@ -2984,12 +3007,52 @@ iwl_mvm_bss_info_changed_ap_ibss(struct iwl_mvm *mvm,
 
 }
 
+/*
+ * Account the time spent in the driver while a station vif connects, from
+ * adding the AP station until it is authorized. Connections that go back
+ * down before that are dropped.
+ */
+static void iwl_mvm_conn_stats_account(struct iwl_mvm *mvm, ktime_t start,
+				       bool done, bool abort)
+{
+	struct iwl_mvm_conn_stats *stats = &mvm->conn_stats;
+	ktime_t now = ktime_get();
+
+	lockdep_assert_held(&mvm->mutex);
+
+	if (!stats->start)
+		return;
+
+	if (abort) {
+		stats->start = 0;
+		return;
+	}
+
+	stats->drv_us += ktime_us_delta(now, start);
+	if (!done)
+		return;
+
+	stats->count++;
+	stats->last_us = ktime_us_delta(now, stats->start);
+	stats->last_drv_us = stats->drv_us;
+	stats->max_drv_us = max(stats->max_drv_us, stats->drv_us);
+	if (stats->avg_drv_us)
+		stats->avg_drv_us = (stats->avg_drv_us * 7 + stats->drv_us) / 8;
+	else
+		stats->avg_drv_us = stats->drv_us;
+	stats->start = 0;
+
+	IWL_DEBUG_INFO(mvm, "connected in %u us, %u us in the driver\n",
+		       stats->last_us, stats->last_drv_us);
+}
+
 static void iwl_mvm_bss_info_changed(struct ieee80211_hw *hw,
 				     struct ieee80211_vif *vif,
 				     struct ieee80211_bss_conf *bss_conf,
 				     u32 changes)
 {
 	struct iwl_mvm *mvm = IWL_MAC80211_GET_MVM(hw);
+	ktime_t start = ktime_get();
 
 	mutex_lock(&mvm->mutex);
 
@@ -3019,6 +3082,9 @@ static void iwl_mvm_bss_info_changed(struct ieee80211_hw *hw,
 		iwl_mvm_set_tx_power(mvm, vif, bss_conf->txpower);
 	}
 
+	if (vif->type == NL80211_IFTYPE_STATION)
+		iwl_mvm_conn_stats_account(mvm, start, false, false);
+
 	mutex_unlock(&mvm->mutex);
 }
 
@@ -3451,6 +3517,7 @@ static int iwl_mvm_mac_sta_state(struct ieee80211_hw *hw,
 	struct iwl_mvm *mvm = IWL_MAC80211_GET_MVM(hw);
 	struct iwl_mvm_vif *mvmvif = iwl_mvm_vif_from_mac80211(vif);
 	struct iwl_mvm_sta *mvm_sta = iwl_mvm_sta_from_mac80211(sta);
+	ktime_t start = ktime_get();
 	int ret;
 
 	IWL_DEBUG_MAC80211(mvm, "station %pM state change %d->%d\n",
@@ -3649,6 +3716,16 @@ static int iwl_mvm_mac_sta_state(struct ieee80211_hw *hw,
 		ret = -EIO;
 	}
  out_unlock:
+	if (vif->type == NL80211_IFTYPE_STATION && !sta->tdls) {
+		if (old_state == IEEE80211_STA_NOTEXIST &&
+		    new_state == IEEE80211_STA_NONE && !ret) {
+			mvm->conn_stats.start = start;
+			mvm->conn_stats.drv_us = 0;
+		}
+		iwl_mvm_conn_stats_account(mvm, start,
+					   new_state == IEEE80211_STA_AUTHORIZED,
+					   ret || new_state < old_state);
+	}
 	mutex_unlock(&mvm->mutex);
 
 	if (sta->tdls && ret == 0) {
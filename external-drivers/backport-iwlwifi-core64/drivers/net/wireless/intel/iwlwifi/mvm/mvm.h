@@ -85,10 +85,13 @@ extern const struct ieee80211_ops iwl_mvm_hw_ops;
  *	be up'ed after the INIT fw asserted. This is useful to be able to use
  *	proprietary tools over testmode to debug the INIT fw.
  * @power_scheme: one of enum iwl_power_scheme
+ * @fast_restart: on firmware restart, skip the INIT image and reuse the
+ *	calibration results already held in the PHY DB
  */
 struct iwl_mvm_mod_params {
 	bool init_dbg;
 	int power_scheme;
+	bool fast_restart;
 };
 extern struct iwl_mvm_mod_params iwlmvm_mod_params;
 
@@ -485,6 +488,41 @@ enum iwl_mvm_sched_scan_pass_all_states {
 	SCHED_SCAN_PASS_ALL_FOUND,
 };
 
+/**
+ * struct iwl_mvm_tt_trend - NIC temperature trend
+ * @valid: a previous sample exists
+ * @last_temp: last temperature sample (Celsius)
+ * @last_ts: jiffies of the last sample
+ * @slope: smoothed temperature slope in milli-Celsius per second
+ * @integral: accumulated time above the backoff setpoint, in
+ *	milli-Celsius * seconds
+ */
+struct iwl_mvm_tt_trend {
+	bool valid;
+	s32 last_temp;
+	unsigned long last_ts;
+	s32 slope;
+	s32 integral;
+};
+
+/**
+ * struct iwl_mvm_tt_stats - thermal throttling statistics
+ * @last_update: jiffies of the last accounting update
+ * @backoff_ms: time spent with a TX backoff above the minimum
+ * @lost_ms: estimated airtime lost to the TX backoff
+ * @ctdp_ms: time spent in a non-zero cTDP cooling state
+ * @changes: TX backoff changes sent to the firmware
+ * @early: changes the trend requested ahead of the step table
+ */
+struct iwl_mvm_tt_stats {
+	unsigned long last_update;
+	u64 backoff_ms;
+	u64 lost_ms;
+	u64 ctdp_ms;
+	u32 changes;
+	u32 early;
+};
+
 /**
  * struct iwl_mvm_tt_mgnt - Thermal Throttling Management structure
  * @ct_kill_exit: worker to exit thermal kill
@@ -493,6 +531,9 @@ enum iwl_mvm_sched_scan_pass_all_states {
  * @min_backoff: The minimal tx backoff due to power restrictions
  * @params: Parameters to configure the thermal throttling algorithm.
  * @throttle: Is thermal throttling is active?
+ * @predictive: derive the tx backoff from the temperature trend
+ * @trend: temperature trend used by the predictive backoff
+ * @stats: throttling statistics
  */
 struct iwl_mvm_tt_mgmt {
 	struct delayed_work ct_kill_exit;
@@ -501,6 +542,9 @@ struct iwl_mvm_tt_mgmt {
 	u32 min_backoff;
 	struct iwl_tt_params params;
 	bool throttle;
+	bool predictive;
+	struct iwl_mvm_tt_trend trend;
+	struct iwl_mvm_tt_stats stats;
 };
 
 #ifdef CONFIG_THERMAL
@@ -624,6 +668,206 @@ struct iwl_mvm_tdls_peer_counter {
 };
 #endif
 
+/**
+ * struct iwl_mvm_rx_batch - frames of one RX queue waiting for the stack
+ * @list: frames mac80211 already processed during the current NAPI poll,
+ *	handed to GRO together once the poll is done
+ */
+struct iwl_mvm_rx_batch {
+#if LINUX_VERSION_IS_GEQ(4,19,0)
+	struct list_head list;
+#else
+	struct sk_buff_head list;
+#endif
+} ____cacheline_aligned_in_smp;
+
+static inline void iwl_mvm_rx_batch_init(struct iwl_mvm_rx_batch *batch)
+{
+#if LINUX_VERSION_IS_GEQ(4,19,0)
+	INIT_LIST_HEAD(&batch->list);
+#else
+	__skb_queue_head_init(&batch->list);
+#endif
+}
+
+/**
+ * struct iwl_mvm_rss_cfg - RSS configuration sent to the firmware
+ * @valid: the configuration was initialized
+ * @key: hash secret key
+ * @indir: indirection table, maps hash buckets to RX queues
+ */
+struct iwl_mvm_rss_cfg {
+	bool valid;
+	__le32 key[IWL_RSS_HASH_KEY_CNT];
+	u8 indir[IWL_RSS_INDIRECTION_TABLE_SIZE];
+};
+
+/**
+ * struct iwl_mvm_restart_stats - firmware restart timing
+ * @start: time the current restart entered mac80211 start, 0 if idle
+ * @up_done: time the runtime firmware finished its configuration
+ * @count: number of completed restarts
+ * @fast: restarts that skipped the INIT image and loaded successfully
+ * @failed: restarts that failed to bring the firmware back up
+ * @load_us: last time spent loading the firmware image(s) and paging
+ * @up_us: last time spent configuring the runtime firmware
+ * @reconfig_us: last time spent by mac80211 replaying its state
+ * @total_us: last total restart time
+ * @max_us: longest total restart time seen
+ */
+struct iwl_mvm_restart_stats {
+	ktime_t start;
+	ktime_t up_done;
+	u32 count;
+	u32 fast;
+	u32 failed;
+	u32 load_us;
+	u32 up_us;
+	u32 reconfig_us;
+	u32 total_us;
+	u32 max_us;
+};
+
+/* number of scan channels */
+#define IWL_SCAN_NUM_CHANNELS 112
+
+/**
+ * struct iwl_mvm_scan_hist - per-channel BSS history for regular scans
+ * @last_seen: jiffies a beacon or probe response was last received on the
+ *	channel (truncated to 32 bits)
+ * @empty_scans: consecutive full dwell regular scans that didn't hear
+ *	anything on the channel, saturating
+ * @scanning: channels covered by the running regular scan
+ * @start: jiffies the running regular scan was started
+ * @full_dwell: the running regular scan uses the full passive dwell
+ * @last_full_dwell: jiffies the last full dwell regular scan was started
+ */
+struct iwl_mvm_scan_hist {
+	u32 last_seen[IWL_SCAN_NUM_CHANNELS];
+	u8 empty_scans[IWL_SCAN_NUM_CHANNELS];
+	DECLARE_BITMAP(scanning, IWL_SCAN_NUM_CHANNELS);
+	u32 start;
+	bool full_dwell;
+	unsigned long last_full_dwell;
+};
+
+/**
+ * struct iwl_mvm_scan_stats - regular scan statistics
+ * @start: time the running regular scan was sent
+ * @count: completed regular scans
+ * @aborted: regular scans the firmware reported as aborted
+ * @short_dwell: scans that used a shortened passive dwell
+ * @reordered: scans whose channels were reordered by BSS history
+ * @last_us: duration of the last regular scan
+ * @avg_us: moving average of the regular scan duration
+ * @max_us: longest regular scan
+ */
+struct iwl_mvm_scan_stats {
+	ktime_t start;
+	u32 count;
+	u32 aborted;
+	u32 short_dwell;
+	u32 reordered;
+	u32 last_us;
+	u32 avg_us;
+	u32 max_us;
+};
+
+/**
+ * struct iwl_mvm_resume_stats - WoWLAN resume timing
+ * @count: number of resumes from D3
+ * @kept: resumes that kept the connection to the AP
+ * @restarts: resumes that had to fall back to a firmware restart
+ * @rt_check_us: last time spent checking the D3 firmware for errors
+ * @d3_resume_us: last time spent in the transport D3 resume handshake
+ * @d0i3_end_us: last time spent waiting for D0I3_END_CMD
+ * @fw_status_us: last time spent querying the wakeup status
+ * @keys_us: last time spent restoring keys and sequence counters
+ * @total_us: last total resume time, not including a restart
+ * @max_us: longest total resume time seen
+ */
+struct iwl_mvm_resume_stats {
+	u32 count;
+	u32 kept;
+	u32 restarts;
+	u32 rt_check_us;
+	u32 d3_resume_us;
+	u32 d0i3_end_us;
+	u32 fw_status_us;
+	u32 keys_us;
+	u32 total_us;
+	u32 max_us;
+};
+
+/**
+ * struct iwl_mvm_cmd_batch - host commands sent back to back
+ * @mvm: the mvm the commands are sent to
+ * @n_cmds: number of commands queued so far
+ * @ret: first error seen while queueing, commands after it are not sent
+ * @start: time the first command was queued
+ *
+ * Commands added to a batch are queued asynchronously, one synchronous
+ * ECHO_CMD in iwl_mvm_cmd_batch_finish() then waits for all of them since
+ * the firmware handles the command queue in order. Only commands whose
+ * response isn't needed can be batched.
+ */
+struct iwl_mvm_cmd_batch {
+	struct iwl_mvm *mvm;
+	u16 n_cmds;
+	int ret;
+	ktime_t start;
+};
+
+/**
+ * struct iwl_mvm_cmd_batch_stats - host command batching statistics
+ * @batches: number of batches completed
+ * @cmds: number of commands sent in batches
+ * @last_us: time the last batch took to complete
+ * @max_us: longest batch completion time
+ */
+struct iwl_mvm_cmd_batch_stats {
+	u32 batches;
+	u32 cmds;
+	u32 last_us;
+	u32 max_us;
+};
+
+/**
+ * struct iwl_mvm_conn_stats - station connection latency
+ * @start: time the AP station of the connection in progress was added,
+ *	0 if none
+ * @drv_us: time spent in station state changes for the connection in
+ *	progress
+ * @count: number of connections (associations and roams) completed
+ * @last_us: last time from adding the AP station to authorizing it
+ * @last_drv_us: driver part of @last_us
+ * @max_drv_us: longest driver time of a connection
+ * @avg_drv_us: moving average of the driver time of a connection
+ */
+struct iwl_mvm_conn_stats {
+	ktime_t start;
+	u32 drv_us;
+	u32 count;
+	u32 last_us;
+	u32 last_drv_us;
+	u32 max_drv_us;
+	u32 avg_drv_us;
+};
+
+/**
+ * struct iwl_mvm_reorder_stats - reorder buffer statistics
+ * @holes: frames that could not be passed up right away and were stored
+ * @timeouts: times the reorder timer had to release frames over a hole
+ * @released: frames released from the reorder buffer
+ * @dropped: duplicate or outdated frames dropped
+ */
+struct iwl_mvm_reorder_stats {
+	u32 holes;
+	u32 timeouts;
+	u32 released;
+	u32 dropped;
+};
+
 /**
  * struct iwl_mvm_reorder_buffer - per ra/tid/queue reorder buffer
  * @head_sn: reorder window head sn
@@ -644,6 +888,8 @@ struct iwl_mvm_tdls_peer_counter {
  * @consec_oldsn_prev_drop: track whether or not an MPDU
  *	that was single/part of the previous A-MPDU was
  *	dropped due to old SN
+ * @stored: bitmap of the entries (sn % buf_size) that hold frames
+ * @stats: reorder statistics, protected by @lock
  */
 struct iwl_mvm_reorder_buffer {
 	u16 head_sn;
@@ -660,6 +906,8 @@ struct iwl_mvm_reorder_buffer {
 	unsigned int consec_oldsn_drops;
 	u32 consec_oldsn_ampdu_gp2;
 	unsigned int consec_oldsn_prev_drop:1;
+	DECLARE_BITMAP(stored, IEEE80211_MAX_AMPDU_BUF);
+	struct iwl_mvm_reorder_stats stats;
 } ____cacheline_aligned_in_smp;
 
 /**
@@ -693,6 +941,8 @@ __aligned(roundup_pow_of_two(sizeof(struct _iwl_mvm_reorder_buf_entry)))
  * @last_rx: last rx jiffies, updated only if timeout passed from last update
  * @session_timer: timer to check if BA session expired, runs at 2 * timeout
  * @mvm: mvm pointer, needed for timer context
+ * @last_nssn_sync: last NSSN sent to all queues, used to coalesce the
+ *	syncs sent by the different queues crossing the same SN (-1 if none)
  * @reorder_buf: reorder buffer, allocated per queue
  * @reorder_buf_data: data
  */
@@ -707,6 +957,7 @@ struct iwl_mvm_baid_data {
 	struct timer_list session_timer;
 	struct iwl_mvm_baid_data __rcu **rcu_ptr;
 	struct iwl_mvm *mvm;
+	int last_nssn_sync;
 	struct iwl_mvm_reorder_buffer reorder_buf[IWL_MAX_RX_HW_QUEUES];
 	struct iwl_mvm_reorder_buf_entry entries[];
 };
@@ -844,6 +1095,12 @@ struct iwl_mvm {
 	bool hw_registered;
 	bool rfkill_safe_init_done;
 
+	struct iwl_mvm_restart_stats restart_stats;
+	struct iwl_mvm_cmd_batch_stats cmd_batch_stats;
+	struct iwl_mvm_conn_stats conn_stats;
+
+	struct iwl_mvm_rss_cfg rss;
+
 	u8 cca_40mhz_workaround;
 
 	u32 ampdu_ref;
@@ -923,6 +1180,9 @@ struct iwl_mvm {
 	/* the vif that requested the current scan */
 	struct iwl_mvm_vif *scan_vif;
 
+	struct iwl_mvm_scan_hist scan_hist;
+	struct iwl_mvm_scan_stats scan_stats;
+
 	/* rx chain antennas set through debugfs for the scan command */
 	u8 scan_rx_ant;
 
@@ -1011,6 +1271,7 @@ struct iwl_mvm {
 	int n_nd_channels;
 	bool net_detect;
 	u8 offload_tid;
+	struct iwl_mvm_resume_stats resume_stats;
 #ifdef CPTCFG_IWLWIFI_DEBUGFS
 	bool d3_wake_sysassert;
 	bool d3_test_active;
@@ -1022,6 +1283,9 @@ struct iwl_mvm {
 
 	wait_queue_head_t rx_sync_waitq;
 
+	/* frames batched per RX queue until the end of the NAPI poll */
+	struct iwl_mvm_rx_batch rx_batch[IWL_MAX_RX_HW_QUEUES];
+
 	/* BT-Coex */
 	struct iwl_bt_coex_profile_notif last_bt_notif;
 	struct iwl_bt_coex_ci_cmd last_bt_ci_cmd;
@@ -1598,6 +1862,14 @@ int __must_check iwl_mvm_send_cmd_status(struct iwl_mvm *mvm,
 int __must_check iwl_mvm_send_cmd_pdu_status(struct iwl_mvm *mvm, u32 id,
 					     u16 len, const void *data,
 					     u32 *status);
+void iwl_mvm_cmd_batch_init(struct iwl_mvm *mvm,
+			    struct iwl_mvm_cmd_batch *batch);
+int iwl_mvm_cmd_batch_add(struct iwl_mvm_cmd_batch *batch,
+			  struct iwl_host_cmd *cmd);
+int iwl_mvm_cmd_batch_send_pdu(struct iwl_mvm *mvm,
+			       struct iwl_mvm_cmd_batch *batch,
+			       u32 id, u32 flags, u16 len, const void *data);
+int iwl_mvm_cmd_batch_finish(struct iwl_mvm_cmd_batch *batch);
 int iwl_mvm_tx_skb_sta(struct iwl_mvm *mvm, struct sk_buff *skb,
 		       struct ieee80211_sta *sta);
 int iwl_mvm_tx_skb_non_sta(struct iwl_mvm *mvm, struct sk_buff *skb);
@@ -1683,6 +1955,7 @@ static inline u32 iwl_mvm_get_phy_config(struct iwl_mvm *mvm)
 
 int iwl_mvm_up(struct iwl_mvm *mvm);
 int iwl_mvm_load_d3_fw(struct iwl_mvm *mvm);
+int iwl_send_rss_cfg_cmd(struct iwl_mvm *mvm);
 
 int iwl_mvm_mac_setup_register(struct iwl_mvm *mvm);
 bool iwl_mvm_bcast_filter_build_cmd(struct iwl_mvm *mvm,
@@ -1706,6 +1979,8 @@ void iwl_mvm_rx_frame_release(struct iwl_mvm *mvm, struct napi_struct *napi,
 			      struct iwl_rx_cmd_buffer *rxb, int queue);
 void iwl_mvm_rx_bar_frame_release(struct iwl_mvm *mvm, struct napi_struct *napi,
 				  struct iwl_rx_cmd_buffer *rxb, int queue);
+void iwl_mvm_rx_mq_done(struct iwl_op_mode *op_mode, struct napi_struct *napi,
+			unsigned int queue);
 void iwl_mvm_rx_queue_notif(struct iwl_mvm *mvm, struct napi_struct *napi,
 			    struct iwl_rx_cmd_buffer *rxb, int queue);
 void iwl_mvm_rx_tx_cmd(struct iwl_mvm *mvm, struct iwl_rx_cmd_buffer *rxb);
@@ -1816,6 +2091,8 @@ int iwl_mvm_scan_stop(struct iwl_mvm *mvm, int type, bool notify);
 int iwl_mvm_max_scan_ie_len(struct iwl_mvm *mvm);
 void iwl_mvm_report_scan_aborted(struct iwl_mvm *mvm);
 void iwl_mvm_scan_timeout_wk(struct work_struct *work);
+void iwl_mvm_scan_hist_rx(struct iwl_mvm *mvm,
+			  struct ieee80211_rx_status *rx_status);
 
 /* Scheduled scan */
 void iwl_mvm_rx_lmac_scan_complete_notif(struct iwl_mvm *mvm,
@@ -2048,6 +2325,7 @@ void iwl_mvm_tt_tx_backoff(struct iwl_mvm *mvm, u32 backoff);
 void iwl_mvm_temp_notif(struct iwl_mvm *mvm,
 			struct iwl_rx_cmd_buffer *rxb);
 void iwl_mvm_tt_handler(struct iwl_mvm *mvm);
+void iwl_mvm_tt_stats_update(struct iwl_mvm *mvm);
 void iwl_mvm_thermal_initialize(struct iwl_mvm *mvm, u32 min_backoff);
 void iwl_mvm_thermal_exit(struct iwl_mvm *mvm);
 void iwl_mvm_set_hw_ctkill_state(struct iwl_mvm *mvm, bool state);
@@ -44,6 +44,7 @@ static const struct iwl_op_mode_ops iwl_mvm_ops_mq;
 
 struct iwl_mvm_mod_params iwlmvm_mod_params = {
 	.power_scheme = IWL_POWER_SCHEME_BPS,
+	.fast_restart = true,
 	/* rest of fields are 0 by default */
 };
 
@@ -53,6 +54,9 @@ MODULE_PARM_DESC(init_dbg,
 module_param_named(power_scheme, iwlmvm_mod_params.power_scheme, int, 0444);
 MODULE_PARM_DESC(power_scheme,
 		 "power management scheme: 1-active, 2-balanced, 3-low power, default: 2");
+module_param_named(fast_restart, iwlmvm_mod_params.fast_restart, bool, 0644);
+MODULE_PARM_DESC(fast_restart,
+		 "reuse INIT calibration data on firmware restart (default: true)");
 
 #ifdef CPTCFG_IWLWIFI_DEVICE_TESTMODE
 static void iwl_mvm_rx_fw_logs(struct iwl_mvm *mvm,
@@ -1177,7 +1181,7 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 	static const u8 no_reclaim_cmds[] = {
 		TX_CMD,
 	};
-	int scan_size;
+	int scan_size, i;
 	u32 min_backoff;
 	enum iwl_amsdu_size rb_size_default;
 	struct iwl_mvm_csme_conn_info *csme_conn_info __maybe_unused;
@@ -1293,6 +1297,8 @@ iwl_op_mode_mvm_start(struct iwl_trans *trans, const struct iwl_cfg *cfg,
 	INIT_LIST_HEAD(&mvm->add_stream_txqs);
 
 	init_waitqueue_head(&mvm->rx_sync_waitq);
+	for (i = 0; i < ARRAY_SIZE(mvm->rx_batch); i++)
+		iwl_mvm_rx_batch_init(&mvm->rx_batch[i]);
 
 #ifdef CPTCFG_IWLMVM_VENDOR_CMDS
 	/*
@@ -1518,7 +1524,6 @@ void iwl_mvm_stop_device(struct iwl_mvm *mvm)
 
 	iwl_fw_dbg_stop_sync(&mvm->fwrt);
 	iwl_trans_stop_device(mvm->trans);
-	iwl_free_fw_paging(&mvm->fwrt);
 	iwl_fw_dump_conf_clear(&mvm->fwrt);
 	iwl_mvm_mei_device_down(mvm);
 }
@@ -2150,4 +2155,5 @@ static const struct iwl_op_mode_ops iwl_mvm_ops_mq = {
 	IWL_MVM_COMMON_TEST_OPS
 	.rx = iwl_mvm_rx_mq,
 	.rx_rss = iwl_mvm_rx_mq_rss,
+	.rx_done = iwl_mvm_rx_mq_done,
 };
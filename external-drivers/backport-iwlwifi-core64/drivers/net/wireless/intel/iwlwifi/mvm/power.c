@@ -21,7 +21,7 @@
 static
 int iwl_mvm_beacon_filter_send_cmd(struct iwl_mvm *mvm,
 				   struct iwl_beacon_filter_cmd *cmd,
-				   u32 flags)
+				   u32 flags, struct iwl_mvm_cmd_batch *batch)
 {
 	u16 len;
 
@@ -62,8 +62,9 @@ int iwl_mvm_beacon_filter_send_cmd(struct iwl_mvm *mvm,
 		len = offsetof(struct iwl_beacon_filter_cmd,
 			       bf_threshold_absolute_low);
 
-	return iwl_mvm_send_cmd_pdu(mvm, REPLY_BEACON_FILTERING_CMD, flags,
-				    len, cmd);
+	return iwl_mvm_cmd_batch_send_pdu(mvm, batch,
+					  REPLY_BEACON_FILTERING_CMD, flags,
+					  len, cmd);
 }
 
 static
@@ -461,7 +462,8 @@ static void iwl_mvm_power_build_cmd(struct iwl_mvm *mvm,
 }
 
 static int iwl_mvm_power_send_cmd(struct iwl_mvm *mvm,
-					 struct ieee80211_vif *vif)
+				  struct ieee80211_vif *vif,
+				  struct iwl_mvm_cmd_batch *batch)
 {
 	struct iwl_mac_power_cmd cmd = {};
 
@@ -471,11 +473,12 @@ static int iwl_mvm_power_send_cmd(struct iwl_mvm *mvm,
 	memcpy(&iwl_mvm_vif_from_mac80211(vif)->mac_pwr_cmd, &cmd, sizeof(cmd));
 #endif
 
-	return iwl_mvm_send_cmd_pdu(mvm, MAC_PM_POWER_TABLE, 0,
-				    sizeof(cmd), &cmd);
+	return iwl_mvm_cmd_batch_send_pdu(mvm, batch, MAC_PM_POWER_TABLE, 0,
+					  sizeof(cmd), &cmd);
 }
 
-int iwl_mvm_power_update_device(struct iwl_mvm *mvm)
+static int __iwl_mvm_power_update_device(struct iwl_mvm *mvm,
+					 struct iwl_mvm_cmd_batch *batch)
 {
 	struct iwl_device_power_cmd cmd = {
 		.flags = 0,
@@ -500,8 +503,13 @@ int iwl_mvm_power_update_device(struct iwl_mvm *mvm)
 			"Sending device power command with flags = 0x%X\n",
 			cmd.flags);
 
-	return iwl_mvm_send_cmd_pdu(mvm, POWER_TABLE_CMD, 0, sizeof(cmd),
-				    &cmd);
+	return iwl_mvm_cmd_batch_send_pdu(mvm, batch, POWER_TABLE_CMD, 0,
+					  sizeof(cmd), &cmd);
+}
+
+int iwl_mvm_power_update_device(struct iwl_mvm *mvm)
+{
+	return __iwl_mvm_power_update_device(mvm, NULL);
 }
 
 void iwl_mvm_power_vif_assoc(struct iwl_mvm *mvm, struct ieee80211_vif *vif)
@@ -799,7 +807,8 @@ iwl_mvm_beacon_filter_debugfs_parameters(struct ieee80211_vif *vif,
 static int _iwl_mvm_enable_beacon_filter(struct iwl_mvm *mvm,
 					 struct ieee80211_vif *vif,
 					 struct iwl_beacon_filter_cmd *cmd,
-					 u32 cmd_flags)
+					 u32 cmd_flags,
+					 struct iwl_mvm_cmd_batch *batch)
 {
 	struct iwl_mvm_vif *mvmvif = iwl_mvm_vif_from_mac80211(vif);
 	int ret;
@@ -810,7 +819,7 @@ static int _iwl_mvm_enable_beacon_filter(struct iwl_mvm *mvm,
 
 	iwl_mvm_beacon_filter_set_cqm_params(mvm, vif, cmd);
 	iwl_mvm_beacon_filter_debugfs_parameters(vif, cmd);
-	ret = iwl_mvm_beacon_filter_send_cmd(mvm, cmd, cmd_flags);
+	ret = iwl_mvm_beacon_filter_send_cmd(mvm, cmd, cmd_flags, batch);
 
 	if (!ret)
 		mvmvif->bf_data.bf_enabled = true;
@@ -827,7 +836,7 @@ int iwl_mvm_enable_beacon_filter(struct iwl_mvm *mvm,
 		.bf_enable_beacon_filter = cpu_to_le32(1),
 	};
 
-	return _iwl_mvm_enable_beacon_filter(mvm, vif, &cmd, flags);
+	return _iwl_mvm_enable_beacon_filter(mvm, vif, &cmd, flags, NULL);
 }
 
 static int _iwl_mvm_disable_beacon_filter(struct iwl_mvm *mvm,
@@ -841,7 +850,7 @@ static int _iwl_mvm_disable_beacon_filter(struct iwl_mvm *mvm,
 	if (vif->type != NL80211_IFTYPE_STATION || vif->p2p)
 		return 0;
 
-	ret = iwl_mvm_beacon_filter_send_cmd(mvm, &cmd, flags);
+	ret = iwl_mvm_beacon_filter_send_cmd(mvm, &cmd, flags, NULL);
 
 	if (!ret)
 		mvmvif->bf_data.bf_enabled = false;
@@ -856,7 +865,8 @@ int iwl_mvm_disable_beacon_filter(struct iwl_mvm *mvm,
 	return _iwl_mvm_disable_beacon_filter(mvm, vif, flags);
 }
 
-static int iwl_mvm_power_set_ps(struct iwl_mvm *mvm)
+static int iwl_mvm_power_set_ps(struct iwl_mvm *mvm,
+				struct iwl_mvm_cmd_batch *batch)
 {
 	bool disable_ps;
 	int ret;
@@ -874,7 +884,7 @@ static int iwl_mvm_power_set_ps(struct iwl_mvm *mvm)
 		bool old_ps_disabled = mvm->ps_disabled;
 
 		mvm->ps_disabled = disable_ps;
-		ret = iwl_mvm_power_update_device(mvm);
+		ret = __iwl_mvm_power_update_device(mvm, batch);
 		if (ret) {
 			mvm->ps_disabled = old_ps_disabled;
 			return ret;
@@ -885,7 +895,8 @@ static int iwl_mvm_power_set_ps(struct iwl_mvm *mvm)
 }
 
 static int iwl_mvm_power_set_ba(struct iwl_mvm *mvm,
-				struct ieee80211_vif *vif)
+				struct ieee80211_vif *vif,
+				struct iwl_mvm_cmd_batch *batch)
 {
 	struct iwl_mvm_vif *mvmvif = iwl_mvm_vif_from_mac80211(vif);
 	struct iwl_beacon_filter_cmd cmd = {
@@ -904,7 +915,7 @@ static int iwl_mvm_power_set_ba(struct iwl_mvm *mvm,
 				       !vif->bss_conf.ps ||
 				       iwl_mvm_vif_low_latency(mvmvif));
 
-	return _iwl_mvm_enable_beacon_filter(mvm, vif, &cmd, 0);
+	return _iwl_mvm_enable_beacon_filter(mvm, vif, &cmd, 0, batch);
 }
 
 int iwl_mvm_power_update_ps(struct iwl_mvm *mvm)
@@ -912,7 +923,7 @@ int iwl_mvm_power_update_ps(struct iwl_mvm *mvm)
 	struct iwl_power_vifs vifs = {
 		.mvm = mvm,
 	};
-	int ret;
+	struct iwl_mvm_cmd_batch batch;
 
 	lockdep_assert_held(&mvm->mutex);
 
@@ -921,14 +932,13 @@ int iwl_mvm_power_update_ps(struct iwl_mvm *mvm)
 					IEEE80211_IFACE_ITER_NORMAL,
 					iwl_mvm_power_get_vifs_iterator, &vifs);
 
-	ret = iwl_mvm_power_set_ps(mvm);
-	if (ret)
-		return ret;
+	/* any error is recorded in the batch and stops further commands */
+	iwl_mvm_cmd_batch_init(mvm, &batch);
 
-	if (vifs.bss_vif)
-		return iwl_mvm_power_set_ba(mvm, vifs.bss_vif);
+	if (!iwl_mvm_power_set_ps(mvm, &batch) && vifs.bss_vif)
+		iwl_mvm_power_set_ba(mvm, vifs.bss_vif, &batch);
 
-	return 0;
+	return iwl_mvm_cmd_batch_finish(&batch);
 }
 
 int iwl_mvm_power_update_mac(struct iwl_mvm *mvm)
@@ -936,7 +946,7 @@ int iwl_mvm_power_update_mac(struct iwl_mvm *mvm)
 	struct iwl_power_vifs vifs = {
 		.mvm = mvm,
 	};
-	int ret;
+	struct iwl_mvm_cmd_batch batch;
 
 	lockdep_assert_held(&mvm->mutex);
 
@@ -947,24 +957,23 @@ int iwl_mvm_power_update_mac(struct iwl_mvm *mvm)
 
 	iwl_mvm_power_set_pm(mvm, &vifs);
 
-	ret = iwl_mvm_power_set_ps(mvm);
-	if (ret)
-		return ret;
+	/*
+	 * The device, MAC and beacon filter power commands don't need each
+	 * other's responses, send them back to back and wait once. Any
+	 * error is recorded in the batch and stops further commands.
+	 */
+	iwl_mvm_cmd_batch_init(mvm, &batch);
 
-	if (vifs.bss_vif) {
-		ret = iwl_mvm_power_send_cmd(mvm, vifs.bss_vif);
-		if (ret)
-			return ret;
-	}
+	iwl_mvm_power_set_ps(mvm, &batch);
 
-	if (vifs.p2p_vif) {
-		ret = iwl_mvm_power_send_cmd(mvm, vifs.p2p_vif);
-		if (ret)
-			return ret;
-	}
+	if (vifs.bss_vif)
+		iwl_mvm_power_send_cmd(mvm, vifs.bss_vif, &batch);
+
+	if (vifs.p2p_vif)
+		iwl_mvm_power_send_cmd(mvm, vifs.p2p_vif, &batch);
 
 	if (vifs.bss_vif)
-		return iwl_mvm_power_set_ba(mvm, vifs.bss_vif);
+		iwl_mvm_power_set_ba(mvm, vifs.bss_vif, &batch);
 
-	return 0;
+	return iwl_mvm_cmd_batch_finish(&batch);
 }
@@ -1528,15 +1528,35 @@ static void rs_set_amsdu_len(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 }
 
 /*
- * setup rate table in uCode
+ * setup rate table in uCode, unless it ends up identical to the one the
+ * uCode already has
  */
 static void rs_update_rate_tbl(struct iwl_mvm *mvm,
 			       struct ieee80211_sta *sta,
 			       struct iwl_lq_sta *lq_sta,
 			       struct iwl_scale_tbl_info *tbl)
 {
+	struct iwl_lq_cmd *lq = &lq_sta->lq;
+	struct iwl_lq_cmd old = *lq;
+	u8 color;
+
 	rs_fill_lq_cmd(mvm, sta, lq_sta, &tbl->rate);
-	iwl_mvm_send_lq_cmd(mvm, &lq_sta->lq);
+
+	/*
+	 * rs_fill_lq_cmd() always bumps the color; if nothing else changed
+	 * keep the old one so that TX statuses still match the table.
+	 */
+	color = lq->flags & LQ_FLAG_COLOR_MSK;
+	lq->flags = LQ_FLAG_COLOR_SET(lq->flags,
+				      old.flags & LQ_FLAG_COLOR_MSK);
+	if (!memcmp(&old, lq, sizeof(old))) {
+		lq_sta->lq_skipped++;
+		return;
+	}
+
+	lq->flags = LQ_FLAG_COLOR_SET(lq->flags, color);
+	lq_sta->lq_sent++;
+	iwl_mvm_send_lq_cmd(mvm, lq);
 }
 
 static bool rs_tweak_rate_tbl(struct iwl_mvm *mvm,
@@ -3027,6 +3047,7 @@ static void __iwl_mvm_rs_tx_status(struct iwl_mvm *mvm,
 	int legacy_success;
 	int retries;
 	int i;
+	bool clean_success = false;
 	struct iwl_lq_cmd *table;
 	u32 lq_hwrate;
 	struct rs_rate lq_rate, tx_resp_rate;
@@ -3242,10 +3263,23 @@ static void __iwl_mvm_rs_tx_status(struct iwl_mvm *mvm,
 			lq_sta->total_success += legacy_success;
 			lq_sta->total_failed += retries + (1 - legacy_success);
 		}
+
+		clean_success = !retries && legacy_success;
 	}
 	/* The last TX rate is cached in lq_sta; it's set in if/else above */
 	lq_sta->last_rate_n_flags = lq_hwrate;
 	IWL_DEBUG_RATE(mvm, "reduced txpower: %d\n", reduced_txp);
+
+	/*
+	 * A non-aggregated frame that went out on the first attempt is very
+	 * unlikely to change the decision, so only run the rate scaling
+	 * every IWL_MVM_RS_SUCCESS_BATCH of those. Failures, retries and
+	 * aggregation statuses are still evaluated right away.
+	 */
+	if (clean_success &&
+	    ++lq_sta->pending_success < IWL_MVM_RS_SUCCESS_BATCH)
+		return;
+	lq_sta->pending_success = 0;
 done:
 	/* See if there's a better rate or modulation mode to try. */
 	if (sta->supp_rates[info->band])
@@ -3791,6 +3825,9 @@ static ssize_t rs_sta_dbgfs_scale_table_read(struct file *file,
 	}
 	desc += scnprintf(buff + desc, bufsz - desc, "last tx rate=0x%X\n",
 			lq_sta->last_rate_n_flags);
+	desc += scnprintf(buff + desc, bufsz - desc,
+			  "lq cmds: sent=%u skipped=%u\n",
+			  lq_sta->lq_sent, lq_sta->lq_skipped);
 	desc += scnprintf(buff + desc, bufsz - desc,
 			"general: flags=0x%X mimo-d=%d s-ant=0x%x d-ant=0x%x\n",
 			lq_sta->lq.flags,
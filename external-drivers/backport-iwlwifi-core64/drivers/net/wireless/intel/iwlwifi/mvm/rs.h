@@ -340,6 +340,12 @@ struct iwl_lq_sta {
 	int optimal_nentries;
 
 	u8 missed_rate_counter;
+	/* clean non-aggregated successes not yet evaluated */
+	u8 pending_success;
+
+	/* LQ commands sent and skipped because the table didn't change */
+	u32 lq_sent;
+	u32 lq_skipped;
 
 	struct iwl_lq_cmd lq;
 	struct iwl_scale_tbl_info lq_info[LQ_SIZE]; /* "active", "search" */
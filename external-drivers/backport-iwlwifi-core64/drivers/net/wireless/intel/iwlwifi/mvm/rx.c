@@ -517,8 +517,10 @@ void iwl_mvm_rx_rx_mpdu(struct iwl_mvm *mvm, struct napi_struct *napi,
 		mvm->sched_scan_pass_all = SCHED_SCAN_PASS_ALL_FOUND;
 
 	if (unlikely(ieee80211_is_beacon(hdr->frame_control) ||
-		     ieee80211_is_probe_resp(hdr->frame_control)))
+		     ieee80211_is_probe_resp(hdr->frame_control))) {
 		rx_status->boottime_ns = ktime_get_boot_ns();
+		iwl_mvm_scan_hist_rx(mvm, rx_status);
+	}
 
 	iwl_mvm_pass_packet_to_mac80211(mvm, sta, napi, skb, hdr, len,
 					crypt_len, rxb);
@@ -236,16 +236,100 @@ static void iwl_mvm_add_rtap_sniffer_config(struct iwl_mvm *mvm,
 	rx_status->flag |= RX_FLAG_RADIOTAP_VENDOR_DATA;
 }
 
+/*
+ * Frames are handed to mac80211 with ieee80211_rx_list(), which appends what
+ * it accepted to a list instead of passing it on to the network stack. In
+ * NAPI context that list is per RX queue and only given to GRO once the NAPI
+ * poll is done (see iwl_mvm_rx_mq_done()), so consecutive frames of a flow -
+ * e.g. the subframes of an A-MSDU - reach GRO together. Outside of NAPI
+ * (reorder timer, delBA) the frames are delivered right away.
+ */
+static void iwl_mvm_rx_batch_flush(struct napi_struct *napi,
+				   struct iwl_mvm_rx_batch *batch)
+{
+	struct sk_buff *skb, *tmp;
+
+	if (!napi) {
+		netif_receive_skb_list(&batch->list);
+		iwl_mvm_rx_batch_init(batch);
+		return;
+	}
+
+#if LINUX_VERSION_IS_GEQ(4,19,0)
+	list_for_each_entry_safe(skb, tmp, &batch->list, list) {
+		skb_list_del_init(skb);
+#else
+	skb_queue_walk_safe(&batch->list, skb, tmp) {
+		__skb_unlink(skb, &batch->list);
+#endif
+		napi_gro_receive(napi, skb);
+	}
+}
+
+void iwl_mvm_rx_mq_done(struct iwl_op_mode *op_mode, struct napi_struct *napi,
+			unsigned int queue)
+{
+	struct iwl_mvm *mvm = IWL_OP_MODE_GET_MVM(op_mode);
+
+	if (WARN_ON_ONCE(queue >= ARRAY_SIZE(mvm->rx_batch)))
+		return;
+
+	iwl_mvm_rx_batch_flush(napi, &mvm->rx_batch[queue]);
+}
+
 /* iwl_mvm_pass_packet_to_mac80211 - passes the packet for mac80211 */
 static void iwl_mvm_pass_packet_to_mac80211(struct iwl_mvm *mvm,
 					    struct napi_struct *napi,
 					    struct sk_buff *skb, int queue,
 					    struct ieee80211_sta *sta)
 {
-	if (iwl_mvm_check_pn(mvm, skb, queue, sta))
+	if (iwl_mvm_check_pn(mvm, skb, queue, sta)) {
 		kfree_skb(skb);
-	else
-		ieee80211_rx_napi(mvm->hw, sta, skb, napi);
+		return;
+	}
+
+	if (!napi) {
+		ieee80211_rx_napi(mvm->hw, sta, skb, NULL);
+		return;
+	}
+
+	rcu_read_lock();
+	ieee80211_rx_list(mvm->hw, sta, skb, &mvm->rx_batch[queue].list);
+	rcu_read_unlock();
+}
+
+/*
+ * Pass a batch of frames that were released in order from a reorder buffer
+ * to mac80211.
+ */
+static void iwl_mvm_pass_packets_to_mac80211(struct iwl_mvm *mvm,
+					     struct napi_struct *napi,
+					     struct sk_buff_head *frames,
+					     int queue,
+					     struct ieee80211_sta *sta)
+{
+	struct iwl_mvm_rx_batch local, *batch = &mvm->rx_batch[queue];
+	struct sk_buff *skb;
+
+	if (skb_queue_empty(frames))
+		return;
+
+	if (!napi) {
+		iwl_mvm_rx_batch_init(&local);
+		batch = &local;
+	}
+
+	rcu_read_lock();
+	while ((skb = __skb_dequeue(frames))) {
+		if (iwl_mvm_check_pn(mvm, skb, queue, sta))
+			kfree_skb(skb);
+		else
+			ieee80211_rx_list(mvm->hw, sta, skb, &batch->list);
+	}
+	rcu_read_unlock();
+
+	if (!napi)
+		iwl_mvm_rx_batch_flush(NULL, &local);
 }
 
 static void iwl_mvm_get_signal_strength(struct iwl_mvm *mvm,
@@ -550,17 +634,52 @@ static bool iwl_mvm_is_sn_less(u16 sn1, u16 sn2, u16 buffer_size)
 	       !ieee80211_sn_less(sn1, sn2 - buffer_size);
 }
 
-static void iwl_mvm_sync_nssn(struct iwl_mvm *mvm, u8 baid, u16 nssn)
+static void iwl_mvm_sync_nssn(struct iwl_mvm *mvm,
+			      struct iwl_mvm_baid_data *baid_data, u16 nssn)
 {
 	struct iwl_mvm_nssn_sync_data notif = {
-		.baid = baid,
+		.baid = baid_data->baid,
 		.nssn = nssn,
 	};
 
+	/*
+	 * Every queue crossing SN 0 or 2048 asks for the same sync; once
+	 * one of them has been sent the others have nothing to add.
+	 */
+	if (xchg(&baid_data->last_nssn_sync, nssn) == nssn)
+		return;
+
 	iwl_mvm_sync_rx_queues_internal(mvm, IWL_MVM_RXQ_NSSN_SYNC, false,
 					&notif, sizeof(notif));
 }
 
+/*
+ * Returns the offset from the head of the window of the first entry at
+ * or after @off that holds frames, or buf_size if there is none.
+ */
+static u16 iwl_mvm_reorder_next_stored(struct iwl_mvm_reorder_buffer *buf,
+				       u16 off)
+{
+	u16 size = buf->buf_size;
+	u16 head = buf->head_sn % size;
+	unsigned long idx;
+
+	if (off >= size)
+		return size;
+
+	if (head + off < size) {
+		idx = find_next_bit(buf->stored, size, head + off);
+		if (idx < size)
+			return idx - head;
+		off = size - head;
+	}
+
+	/* the window wrapped around the end of the buffer */
+	idx = find_next_bit(buf->stored, head, head + off - size);
+
+	return idx < head ? idx + size - head : size;
+}
+
 #define RX_REORDER_BUF_TIMEOUT_MQ (HZ / 10)
 
 enum iwl_mvm_release_flags {
@@ -578,10 +697,13 @@ static void iwl_mvm_release_frames(struct iwl_mvm *mvm,
 	struct iwl_mvm_reorder_buf_entry *entries =
 		&baid_data->entries[reorder_buf->queue *
 				    baid_data->entries_per_queue];
+	struct sk_buff_head frames;
 	u16 ssn = reorder_buf->head_sn;
 
 	lockdep_assert_held(&reorder_buf->lock);
 
+	__skb_queue_head_init(&frames);
+
 	/*
 	 * We keep the NSSN not too far behind, if we are sync'ing it and it
 	 * is more than 2048 ahead of us, it must be behind us. Discard it.
@@ -601,33 +723,38 @@ static void iwl_mvm_release_frames(struct iwl_mvm *mvm,
 	while (iwl_mvm_is_sn_less(ssn, nssn, reorder_buf->buf_size)) {
 		int index = ssn % reorder_buf->buf_size;
 		struct sk_buff_head *skb_list = &entries[index].e.frames;
-		struct sk_buff *skb;
 
 		ssn = ieee80211_sn_inc(ssn);
 		if ((flags & IWL_MVM_RELEASE_SEND_RSS_SYNC) &&
 		    (ssn == 2048 || ssn == 0))
-			iwl_mvm_sync_nssn(mvm, baid_data->baid, ssn);
+			iwl_mvm_sync_nssn(mvm, baid_data, ssn);
 
 		/*
-		 * Empty the list. Will have more than one frame for A-MSDU.
-		 * Empty list is valid as well since nssn indicates frames were
+		 * Collect the list. Will have more than one frame for A-MSDU.
+		 * Empty entry is valid as well since nssn indicates frames were
 		 * received.
 		 */
-		while ((skb = __skb_dequeue(skb_list))) {
-			iwl_mvm_pass_packet_to_mac80211(mvm, napi, skb,
-							reorder_buf->queue,
-							sta);
-			reorder_buf->num_stored--;
-		}
+		if (!test_and_clear_bit(index, reorder_buf->stored))
+			continue;
+
+		reorder_buf->num_stored -= skb_queue_len(skb_list);
+		iwl_trans_tpt_hist(mvm->trans, IWL_TPT_HIST_REORDER_HOLD_US,
+				   jiffies_to_usecs(jiffies -
+						    entries[index].e.reorder_time));
+		skb_queue_splice_tail_init(skb_list, &frames);
 	}
 	reorder_buf->head_sn = nssn;
 
+	reorder_buf->stats.released += skb_queue_len(&frames);
+	iwl_mvm_pass_packets_to_mac80211(mvm, napi, &frames,
+					 reorder_buf->queue, sta);
+
 set_timer:
 	if (reorder_buf->num_stored && !reorder_buf->removed) {
-		u16 index = reorder_buf->head_sn % reorder_buf->buf_size;
+		u16 index = (reorder_buf->head_sn +
+			     iwl_mvm_reorder_next_stored(reorder_buf, 0)) %
+			    reorder_buf->buf_size;
 
-		while (skb_queue_empty(&entries[index].e.frames))
-			index = (index + 1) % reorder_buf->buf_size;
 		/* modify timer to match next frame's expiration time */
 		mod_timer(&reorder_buf->reorder_timer,
 			  entries[index].e.reorder_time + 1 +
@@ -644,7 +771,7 @@ void iwl_mvm_reorder_timer_expired(struct timer_list *t)
 		iwl_mvm_baid_data_from_reorder_buf(buf);
 	struct iwl_mvm_reorder_buf_entry *entries =
 		&baid_data->entries[buf->queue * baid_data->entries_per_queue];
-	int i;
+	int i, prev = -1;
 	u16 sn = 0, index = 0;
 	bool expired = false;
 	bool cont = false;
@@ -656,17 +783,18 @@ void iwl_mvm_reorder_timer_expired(struct timer_list *t)
 		return;
 	}
 
-	for (i = 0; i < buf->buf_size ; i++) {
+	for (i = iwl_mvm_reorder_next_stored(buf, 0); i < buf->buf_size;
+	     i = iwl_mvm_reorder_next_stored(buf, i + 1)) {
 		index = (buf->head_sn + i) % buf->buf_size;
 
-		if (skb_queue_empty(&entries[index].e.frames)) {
-			/*
-			 * If there is a hole and the next frame didn't expire
-			 * we want to break and not advance SN
-			 */
+		/*
+		 * If there is a hole and the next frame didn't expire
+		 * we want to break and not advance SN
+		 */
+		if (i != prev + 1)
 			cont = false;
-			continue;
-		}
+		prev = i;
+
 		if (!cont &&
 		    !time_after(jiffies, entries[index].e.reorder_time +
 					 RX_REORDER_BUF_TIMEOUT_MQ))
@@ -693,6 +821,7 @@ void iwl_mvm_reorder_timer_expired(struct timer_list *t)
 			     sta_id, sn);
 		iwl_mvm_event_frame_timeout_callback(buf->mvm, mvmsta->vif,
 						     sta, baid_data->tid);
+		buf->stats.timeouts++;
 		iwl_mvm_release_frames(buf->mvm, sta, NULL, baid_data,
 				       buf, sn, IWL_MVM_RELEASE_SEND_RSS_SYNC);
 		rcu_read_unlock();
@@ -1037,7 +1166,7 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 			 * when it crosses 0 and 2048.
 			 */
 			if (sn == 2048 || sn == 0)
-				iwl_mvm_sync_nssn(mvm, baid, sn);
+				iwl_mvm_sync_nssn(mvm, baid_data, sn);
 			buffer->head_sn = nssn;
 		}
 		/* No need to update AMSDU last SN - we are moving the head */
@@ -1056,7 +1185,7 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 	if (!buffer->num_stored && sn == buffer->head_sn) {
 		if (!amsdu || last_subframe) {
 			if (sn == 2048 || sn == 0)
-				iwl_mvm_sync_nssn(mvm, baid, sn);
+				iwl_mvm_sync_nssn(mvm, baid_data, sn);
 			buffer->head_sn = ieee80211_sn_inc(buffer->head_sn);
 		}
 		/* No need to update AMSDU last SN - we are moving the head */
@@ -1085,6 +1214,10 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 	__skb_queue_tail(&entries[index].e.frames, skb);
 	buffer->num_stored++;
 	entries[index].e.reorder_time = jiffies;
+	if (!tail) {
+		__set_bit(index, buffer->stored);
+		buffer->stats.holes++;
+	}
 
 	if (amsdu) {
 		buffer->last_amsdu = sn;
@@ -1111,6 +1244,8 @@ static bool iwl_mvm_reorder(struct iwl_mvm *mvm,
 	return true;
 
 drop:
+	if (!ieee80211_is_back_req(hdr->frame_control))
+		buffer->stats.dropped++;
 	kfree_skb(skb);
 	spin_unlock_bh(&buffer->lock);
 	return true;
@@ -2002,8 +2137,10 @@ void iwl_mvm_rx_mpdu_mq(struct iwl_mvm *mvm, struct napi_struct *napi,
 			mvm->sched_scan_pass_all = SCHED_SCAN_PASS_ALL_FOUND;
 
 		if (unlikely(ieee80211_is_beacon(hdr->frame_control) ||
-			     ieee80211_is_probe_resp(hdr->frame_control)))
+			     ieee80211_is_probe_resp(hdr->frame_control))) {
 			rx_status->boottime_ns = ktime_get_boot_ns();
+			iwl_mvm_scan_hist_rx(mvm, rx_status);
+		}
 	}
 
 	if (iwl_mvm_create_skb(mvm, skb, hdr, len, crypt_len, rxb)) {
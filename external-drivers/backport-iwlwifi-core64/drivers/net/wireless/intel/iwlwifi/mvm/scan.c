@@ -19,6 +19,7 @@
 
 #define IWL_SCAN_DWELL_ACTIVE		10
 #define IWL_SCAN_DWELL_PASSIVE		110
+#define IWL_SCAN_DWELL_PASSIVE_SHORT	50
 #define IWL_SCAN_DWELL_FRAGMENTED	44
 #define IWL_SCAN_DWELL_EXTENDED		90
 #define IWL_SCAN_NUM_OF_FRAGS		3
@@ -34,8 +35,6 @@
 #define IWL_SCAN_ADWELL_DEFAULT_LB_N_APS 2
 /* adaptive dwell default APs number in social channels (1, 6, 11) */
 #define IWL_SCAN_ADWELL_DEFAULT_N_APS_SOCIAL 10
-/* number of scan channels */
-#define IWL_SCAN_NUM_CHANNELS 112
 /* adaptive dwell number of APs override mask for p2p friendly GO */
 #define IWL_SCAN_ADWELL_N_APS_GO_FRIENDLY_BIT BIT(20)
 /* adaptive dwell number of APs override mask for social channels */
@@ -48,6 +47,13 @@
 /* minimal number of 2GHz and 5GHz channels in the regular scan request */
 #define IWL_MVM_6GHZ_PASSIVE_SCAN_MIN_CHANS 4
 
+/* a BSS heard on a channel within this time moves it to the list front */
+#define IWL_MVM_SCAN_HIST_RECENT	(300 * HZ)
+/* full dwell scans without any BSS before the passive dwell is shortened */
+#define IWL_MVM_SCAN_HIST_EMPTY_SCANS	3
+/* passive channels get a full dwell at least this often */
+#define IWL_MVM_SCAN_FULL_DWELL_INTERVAL (60 * HZ)
+
 struct iwl_mvm_scan_timing_params {
 	u32 suspend_time;
 	u32 max_out_time;
@@ -96,6 +102,8 @@ struct iwl_mvm_scan_params {
 	int n_scan_plans;
 	struct cfg80211_sched_scan_plan *scan_plans;
 	bool iter_notif;
+	/* per LMAC: use the short passive dwell */
+	bool short_passive[SCAN_TWO_LMACS];
 #ifdef CPTCFG_IWLWIFI_WIFI_6_SUPPORT
 	struct cfg80211_scan_6ghz_params *scan_6ghz_params;
 	u32 n_6ghz_params;
@@ -355,6 +363,32 @@ void iwl_mvm_rx_scan_match_found(struct iwl_mvm *mvm,
 	ieee80211_sched_scan_results(mvm->hw);
 }
 
+/* account a finished regular scan in the stats and the BSS history */
+static void iwl_mvm_scan_regular_done(struct iwl_mvm *mvm, bool aborted)
+{
+	struct iwl_mvm_scan_stats *stats = &mvm->scan_stats;
+	struct iwl_mvm_scan_hist *hist = &mvm->scan_hist;
+	u32 us = ktime_us_delta(ktime_get(), stats->start);
+	int idx;
+
+	if (aborted) {
+		stats->aborted++;
+		return;
+	}
+
+	stats->count++;
+	stats->last_us = us;
+	stats->max_us = max(stats->max_us, us);
+	stats->avg_us = stats->avg_us ? (stats->avg_us * 7 + us) / 8 : us;
+
+	for_each_set_bit(idx, hist->scanning, IWL_SCAN_NUM_CHANNELS) {
+		if ((s32)(hist->last_seen[idx] - hist->start) >= 0)
+			hist->empty_scans[idx] = 0;
+		else if (hist->full_dwell && hist->empty_scans[idx] < U8_MAX)
+			hist->empty_scans[idx]++;
+	}
+}
+
 static const char *iwl_mvm_ebs_status_str(enum iwl_scan_ebs_status status)
 {
 	switch (status) {
@@ -440,6 +474,7 @@ void iwl_mvm_rx_lmac_scan_complete_notif(struct iwl_mvm *mvm,
 			       iwl_mvm_ebs_status_str(scan_notif->ebs_status));
 
 		mvm->scan_status &= ~IWL_MVM_SCAN_REGULAR;
+		iwl_mvm_scan_regular_done(mvm, aborted);
 		ieee80211_scan_completed(mvm->hw, &info);
 		cancel_delayed_work(&mvm->scan_timeout_dwork);
 		iwl_mvm_resume_tcm(mvm);
@@ -820,12 +855,20 @@ iwl_mvm_build_scan_probe(struct iwl_mvm *mvm, struct ieee80211_vif *vif,
 	}
 }
 
+static u8 iwl_mvm_scan_passive_dwell(struct iwl_mvm_scan_params *params,
+				     int lmac)
+{
+	return params->short_passive[lmac] ? IWL_SCAN_DWELL_PASSIVE_SHORT :
+					     IWL_SCAN_DWELL_PASSIVE;
+}
+
 static void iwl_mvm_scan_lmac_dwell(struct iwl_mvm *mvm,
 				    struct iwl_scan_req_lmac *cmd,
 				    struct iwl_mvm_scan_params *params)
 {
 	cmd->active_dwell = IWL_SCAN_DWELL_ACTIVE;
-	cmd->passive_dwell = IWL_SCAN_DWELL_PASSIVE;
+	cmd->passive_dwell = iwl_mvm_scan_passive_dwell(params,
+							SCAN_LB_LMAC_IDX);
 	cmd->fragmented_dwell = IWL_SCAN_DWELL_FRAGMENTED;
 	cmd->extended_dwell = IWL_SCAN_DWELL_EXTENDED;
 	cmd->max_out_time = cpu_to_le32(scan_timing[params->type].max_out_time);
@@ -1302,7 +1345,7 @@ static void iwl_mvm_scan_umac_dwell(struct iwl_mvm *mvm,
 
 	timing = &scan_timing[params->type];
 	active_dwell = IWL_SCAN_DWELL_ACTIVE;
-	passive_dwell = IWL_SCAN_DWELL_PASSIVE;
+	passive_dwell = iwl_mvm_scan_passive_dwell(params, SCAN_LB_LMAC_IDX);
 
 	if (iwl_mvm_is_adaptive_dwell_supported(mvm)) {
 		cmd->v7.adwell_default_n_aps_social =
@@ -1351,7 +1394,8 @@ static void iwl_mvm_scan_umac_dwell(struct iwl_mvm *mvm,
 				cmd->v8.active_dwell[SCAN_HB_LMAC_IDX] =
 					active_dwell;
 				cmd->v8.passive_dwell[SCAN_HB_LMAC_IDX] =
-					passive_dwell;
+					iwl_mvm_scan_passive_dwell(params,
+							SCAN_HB_LMAC_IDX);
 			}
 		}
 	} else {
@@ -1405,11 +1449,10 @@ iwl_mvm_scan_umac_dwell_v10(struct iwl_mvm *mvm,
 			    struct iwl_mvm_scan_params *params)
 {
 	struct iwl_mvm_scan_timing_params *timing, *hb_timing;
-	u8 active_dwell, passive_dwell;
+	u8 active_dwell;
 
 	timing = &scan_timing[params->type];
 	active_dwell = IWL_SCAN_DWELL_ACTIVE;
-	passive_dwell = IWL_SCAN_DWELL_PASSIVE;
 
 	general_params->adwell_default_social_chn =
 		IWL_SCAN_ADWELL_DEFAULT_N_APS_SOCIAL;
@@ -1441,9 +1484,11 @@ iwl_mvm_scan_umac_dwell_v10(struct iwl_mvm *mvm,
 		cpu_to_le32(hb_timing->suspend_time);
 
 	general_params->active_dwell[SCAN_LB_LMAC_IDX] = active_dwell;
-	general_params->passive_dwell[SCAN_LB_LMAC_IDX] = passive_dwell;
+	general_params->passive_dwell[SCAN_LB_LMAC_IDX] =
+		iwl_mvm_scan_passive_dwell(params, SCAN_LB_LMAC_IDX);
 	general_params->active_dwell[SCAN_HB_LMAC_IDX] = active_dwell;
-	general_params->passive_dwell[SCAN_HB_LMAC_IDX] = passive_dwell;
+	general_params->passive_dwell[SCAN_HB_LMAC_IDX] =
+		iwl_mvm_scan_passive_dwell(params, SCAN_HB_LMAC_IDX);
 }
 
 struct iwl_mvm_scan_channel_segment {
@@ -1522,6 +1567,118 @@ static int iwl_mvm_scan_ch_and_band_to_idx(u8 channel_id, u8 band)
 	return -EINVAL;
 }
 
+void iwl_mvm_scan_hist_rx(struct iwl_mvm *mvm,
+			  struct ieee80211_rx_status *rx_status)
+{
+	int idx = iwl_mvm_scan_ch_and_band_to_idx(
+			ieee80211_frequency_to_channel(rx_status->freq),
+			iwl_mvm_phy_band_from_nl80211(rx_status->band));
+
+	if (idx >= 0)
+		mvm->scan_hist.last_seen[idx] = jiffies;
+}
+
+static int iwl_mvm_scan_hist_idx(struct ieee80211_channel *chan)
+{
+	return iwl_mvm_scan_ch_and_band_to_idx(chan->hw_value,
+				iwl_mvm_phy_band_from_nl80211(chan->band));
+}
+
+static bool iwl_mvm_scan_hist_recent(struct iwl_mvm *mvm,
+				     struct ieee80211_channel *chan)
+{
+	int idx = iwl_mvm_scan_hist_idx(chan);
+
+	return idx >= 0 && mvm->scan_hist.last_seen[idx] &&
+	       (u32)jiffies - mvm->scan_hist.last_seen[idx] <
+	       IWL_MVM_SCAN_HIST_RECENT;
+}
+
+/*
+ * Returns a copy of the channel list with the channels that recently had
+ * a BSS first, or NULL if that wouldn't change the order.
+ */
+static struct ieee80211_channel **
+iwl_mvm_scan_hist_order(struct iwl_mvm *mvm,
+			struct ieee80211_channel **channels, u32 n_channels)
+{
+	struct ieee80211_channel **order;
+	bool moved = false;
+	u32 i, n = 0;
+
+	order = kmalloc_array(n_channels, sizeof(*order), GFP_KERNEL);
+	if (!order)
+		return NULL;
+
+	for (i = 0; i < n_channels; i++) {
+		if (!iwl_mvm_scan_hist_recent(mvm, channels[i]))
+			continue;
+		moved |= n != i;
+		order[n++] = channels[i];
+	}
+
+	if (!moved) {
+		kfree(order);
+		return NULL;
+	}
+
+	for (i = 0; i < n_channels; i++)
+		if (!iwl_mvm_scan_hist_recent(mvm, channels[i]))
+			order[n++] = channels[i];
+
+	return order;
+}
+
+/*
+ * Shorten the passive dwell of an LMAC when none of its passive channels
+ * had a BSS during the last few full dwell scans. A full dwell is still
+ * used every IWL_MVM_SCAN_FULL_DWELL_INTERVAL so new networks show up.
+ */
+static void iwl_mvm_scan_hist_dwell(struct iwl_mvm *mvm,
+				    struct iwl_mvm_scan_params *params)
+{
+	struct iwl_mvm_scan_hist *hist = &mvm->scan_hist;
+	bool passive[SCAN_TWO_LMACS] = {};
+	bool busy[SCAN_TWO_LMACS] = {};
+	u32 i;
+
+	if (time_after(jiffies, hist->last_full_dwell +
+				IWL_MVM_SCAN_FULL_DWELL_INTERVAL))
+		return;
+
+	for (i = 0; i < params->n_channels; i++) {
+		struct ieee80211_channel *chan = params->channels[i];
+		int lmac = SCAN_LB_LMAC_IDX;
+		int idx;
+
+		if (!(chan->flags & IEEE80211_CHAN_NO_IR))
+			continue;
+
+		if (iwl_mvm_is_cdb_supported(mvm) &&
+		    chan->band != NL80211_BAND_2GHZ)
+			lmac = SCAN_HB_LMAC_IDX;
+
+		passive[lmac] = true;
+		idx = iwl_mvm_scan_hist_idx(chan);
+		if (idx < 0 ||
+		    hist->empty_scans[idx] < IWL_MVM_SCAN_HIST_EMPTY_SCANS)
+			busy[lmac] = true;
+	}
+
+	/* older commands have a single passive dwell for both LMACs */
+	if (!iwl_mvm_is_cdb_supported(mvm) ||
+	    !iwl_mvm_is_adaptive_dwell_v2_supported(mvm)) {
+		passive[SCAN_LB_LMAC_IDX] |= passive[SCAN_HB_LMAC_IDX];
+		passive[SCAN_HB_LMAC_IDX] = passive[SCAN_LB_LMAC_IDX];
+		busy[SCAN_LB_LMAC_IDX] |= busy[SCAN_HB_LMAC_IDX];
+		busy[SCAN_HB_LMAC_IDX] = busy[SCAN_LB_LMAC_IDX];
+	}
+
+	/* an LMAC without passive channels has nothing to shorten */
+	for (i = 0; i < SCAN_TWO_LMACS; i++)
+		params->short_passive[i] = passive[i] && !busy[i];
+}
+
 static const u8 p2p_go_friendly_chs[] = {
 	36, 40, 44, 48, 149, 153, 157, 161, 165,
 };
@@ -2630,7 +2787,10 @@ int iwl_mvm_reg_scan_start(struct iwl_mvm *mvm, struct ieee80211_vif *vif,
 		.dataflags = { IWL_HCMD_DFL_NOCOPY, },
 	};
 	struct iwl_mvm_scan_params params = {};
+	struct iwl_mvm_scan_hist *hist = &mvm->scan_hist;
+	struct ieee80211_channel **order = NULL;
 	int ret, uid;
+	u32 i;
 	struct cfg80211_sched_scan_plan scan_plan = { .iterations = 1 };
 
 	lockdep_assert_held(&mvm->mutex);
@@ -2677,12 +2837,24 @@ int iwl_mvm_reg_scan_start(struct iwl_mvm *mvm, struct ieee80211_vif *vif,
 	if (req->duration)
 		params.iter_notif = true;
 
+	/* 6 GHz collocated parameters refer to the channels by index */
+#ifdef CPTCFG_IWLWIFI_WIFI_6_SUPPORT
+	if (!params.scan_6ghz)
+#endif
+		order = iwl_mvm_scan_hist_order(mvm, params.channels,
+						params.n_channels);
+	if (order)
+		params.channels = order;
+
+	iwl_mvm_scan_hist_dwell(mvm, &params);
+
 	iwl_mvm_build_scan_probe(mvm, vif, ies, &params);
 
 	iwl_mvm_scan_6ghz_passive_scan(mvm, &params, vif);
 
 	uid = iwl_mvm_build_scan_cmd(mvm, vif, &hcmd, &params,
 				     IWL_MVM_SCAN_REGULAR);
+	kfree(order);
 
 	if (uid < 0)
 		return uid;
@@ -2705,6 +2877,27 @@ int iwl_mvm_reg_scan_start(struct iwl_mvm *mvm, struct ieee80211_vif *vif,
 	mvm->scan_status |= IWL_MVM_SCAN_REGULAR;
 	mvm->scan_vif = iwl_mvm_vif_from_mac80211(vif);
 
+	mvm->scan_stats.start = ktime_get();
+	if (order)
+		mvm->scan_stats.reordered++;
+
+	hist->start = jiffies;
+	/* only LMACs with passive channels can have been shortened */
+	hist->full_dwell = !params.short_passive[SCAN_LB_LMAC_IDX] &&
+			   !params.short_passive[SCAN_HB_LMAC_IDX];
+	if (hist->full_dwell)
+		hist->last_full_dwell = jiffies;
+	else
+		mvm->scan_stats.short_dwell++;
+
+	bitmap_zero(hist->scanning, IWL_SCAN_NUM_CHANNELS);
+	for (i = 0; i < req->n_channels; i++) {
+		int idx = iwl_mvm_scan_hist_idx(req->channels[i]);
+
+		if (idx >= 0)
+			__set_bit(idx, hist->scanning);
+	}
+
 #ifdef CPTCFG_IWLWIFI_WIFI_6_SUPPORT
 	if (params.enable_6ghz_passive)
 		mvm->last_6ghz_passive_scan_jiffies = jiffies;
@@ -2873,6 +3066,7 @@ void iwl_mvm_rx_umac_scan_complete_notif(struct iwl_mvm *mvm,
 		};
 
 		memcpy(info.tsf_bssid, mvm->scan_vif->bssid, ETH_ALEN);
+		iwl_mvm_scan_regular_done(mvm, aborted);
 		ieee80211_scan_completed(mvm->hw, &info);
 		mvm->scan_vif = NULL;
 		cancel_delayed_work(&mvm->scan_timeout_dwork);
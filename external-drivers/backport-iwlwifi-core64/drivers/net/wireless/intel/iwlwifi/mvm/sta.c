@@ -715,16 +715,46 @@ static int iwl_mvm_find_free_queue(struct iwl_mvm *mvm, u8 sta_id,
 	return -ENOSPC;
 }
 
+/*
+ * Size a data queue for the largest BA window the station can use. Only
+ * HE peers can run 256 frame aggregates, which is what the large rings
+ * exist for; anything more than the window for other peers just adds
+ * latency and DMA memory.
+ */
+static int iwl_mvm_txq_size(struct iwl_mvm *mvm, u8 sta_id)
+{
+	u32 size = max_t(u32, IWL_DEFAULT_QUEUE_SIZE,
+			 mvm->trans->cfg->min_256_ba_txq_size);
+	struct ieee80211_sta *sta;
+
+	if (sta_id >= mvm->fw->ucode_capa.num_stations)
+		return size;
+
+	sta = rcu_dereference_protected(mvm->fw_id_to_mac_id[sta_id],
+					lockdep_is_held(&mvm->mutex));
+	if (IS_ERR_OR_NULL(sta) || sta->he_cap.has_he)
+		return size;
+
+	if (sta->ht_cap.ht_supported)
+		return max_t(u32, IWL_DEFAULT_QUEUE_SIZE,
+			     mvm->trans->cfg->min_txq_size);
+
+	/* no aggregation at all */
+	return max_t(u32, IWL_DEFAULT_QUEUE_SIZE / 4,
+		     mvm->trans->cfg->min_txq_size);
+}
+
 static int iwl_mvm_tvqm_enable_txq(struct iwl_mvm *mvm,
 				   u8 sta_id, u8 tid, unsigned int timeout)
 {
-	int queue, size = max_t(u32, IWL_DEFAULT_QUEUE_SIZE,
-				mvm->trans->cfg->min_256_ba_txq_size);
+	int queue, size;
 
 	if (tid == IWL_MAX_TID_COUNT) {
 		tid = IWL_MGMT_TID;
 		size = max_t(u32, IWL_MGMT_QUEUE_SIZE,
 			     mvm->trans->cfg->min_txq_size);
+	} else {
+		size = iwl_mvm_txq_size(mvm, sta_id);
 	}
 
 	do {
@@ -2486,6 +2516,7 @@ static void iwl_mvm_free_reorder(struct iwl_mvm *mvm,
 
 		for (j = 0; j < reorder_buf->buf_size; j++)
 			__skb_queue_purge(&entries[j].e.frames);
+		bitmap_zero(reorder_buf->stored, IEEE80211_MAX_AMPDU_BUF);
 		/*
 		 * Prevent timer re-arm. This prevents a very far fetched case
 		 * where we timed out on the notification. There may be prior
@@ -2523,6 +2554,8 @@ static void iwl_mvm_init_reorder_buffer(struct iwl_mvm *mvm,
 		reorder_buf->mvm = mvm;
 		reorder_buf->queue = i;
 		reorder_buf->valid = false;
+		bitmap_zero(reorder_buf->stored, IEEE80211_MAX_AMPDU_BUF);
+		memset(&reorder_buf->stats, 0, sizeof(reorder_buf->stats));
 		for (j = 0; j < reorder_buf->buf_size; j++)
 			__skb_queue_head_init(&entries[j].e.frames);
 	}
@@ -2647,6 +2680,7 @@ int iwl_mvm_sta_rx_agg(struct iwl_mvm *mvm, struct ieee80211_sta *sta,
 		baid_data->mvm = mvm;
 		baid_data->tid = tid;
 		baid_data->sta_id = mvm_sta->sta_id;
+		baid_data->last_nssn_sync = -1;
 
 		mvm_sta->tid_to_baid[tid] = baid;
 		if (timeout)
@@ -10,6 +10,123 @@
 
 #define IWL_MVM_TEMP_NOTIF_WAIT_TIMEOUT	HZ
 
+/* how far ahead the predictive backoff looks along the temperature slope */
+#define IWL_MVM_TT_PREDICT_SEC		10
+/* samples further apart than this don't give a meaningful slope */
+#define IWL_MVM_TT_TREND_MAX_AGE	(30 * HZ)
+/* integral term limit (mC * s) and its weight (mC * s per usec backoff) */
+#define IWL_MVM_TT_INTEGRAL_MAX		(60 * 1000)
+#define IWL_MVM_TT_INTEGRAL_DIV		50
+/* nominal TX opportunity used to estimate the airtime lost to backoff */
+#define IWL_MVM_TT_TXOP_US		5484
+
+static s32 iwl_mvm_tt_setpoint(struct iwl_mvm *mvm)
+{
+	/* start backing off one degree below the first table entry */
+	return mvm->thermal_throttle.params.tx_backoff[0].temperature - 1;
+}
+
+static void iwl_mvm_tt_trend_update(struct iwl_mvm *mvm, s32 temp)
+{
+	struct iwl_mvm_tt_trend *trend = &mvm->thermal_throttle.trend;
+	unsigned long now = jiffies;
+	long dt = now - trend->last_ts;
+	s32 setpoint = iwl_mvm_tt_setpoint(mvm);
+
+	if (trend->valid && !dt)
+		return;
+
+	if (trend->valid && dt < IWL_MVM_TT_TREND_MAX_AGE) {
+		s32 slope = (temp - trend->last_temp) * 1000 * HZ / dt;
+
+		trend->slope = (trend->slope + slope) / 2;
+
+		if (trend->last_temp >= setpoint) {
+			s64 integral = trend->integral +
+				div_s64((s64)(trend->last_temp - setpoint) *
+					1000 * dt, HZ);
+
+			trend->integral = min_t(s64, integral,
+						IWL_MVM_TT_INTEGRAL_MAX);
+		}
+	} else {
+		trend->slope = 0;
+	}
+
+	if (temp < setpoint)
+		trend->integral = 0;
+
+	trend->last_temp = temp;
+	trend->last_ts = now;
+	trend->valid = true;
+}
+
+/*
+ * Predictive backoff: linearly interpolate the backoff table at the
+ * temperature expected IWL_MVM_TT_PREDICT_SEC from now (proportional and
+ * derivative terms), plus an integral term for time spent above the
+ * setpoint. This ramps the backoff up smoothly before the step table
+ * would kick in, instead of jumping between its entries.
+ */
+static u32 iwl_mvm_tt_predict_backoff(struct iwl_mvm *mvm, s32 temperature)
+{
+	struct iwl_mvm_tt_mgmt *tt = &mvm->thermal_throttle;
+	struct iwl_tt_params *params = &tt->params;
+	s32 predicted, lo_temp, hi_temp;
+	u32 lo_backoff = 0, hi_backoff, backoff;
+	int i;
+
+	predicted = temperature * 1000 +
+		    tt->trend.slope * IWL_MVM_TT_PREDICT_SEC;
+
+	lo_temp = iwl_mvm_tt_setpoint(mvm) * 1000;
+	if (predicted <= lo_temp)
+		return 0;
+
+	backoff = params->tx_backoff[TT_TX_BACKOFF_SIZE - 1].backoff;
+	for (i = 0; i < TT_TX_BACKOFF_SIZE; i++) {
+		hi_temp = params->tx_backoff[i].temperature * 1000;
+		hi_backoff = params->tx_backoff[i].backoff;
+
+		if (predicted < hi_temp && hi_temp > lo_temp) {
+			backoff = lo_backoff +
+				  div_s64((s64)((s32)hi_backoff -
+						(s32)lo_backoff) *
+					  (predicted - lo_temp),
+					  hi_temp - lo_temp);
+			break;
+		}
+
+		lo_temp = hi_temp;
+		lo_backoff = hi_backoff;
+	}
+
+	backoff += tt->trend.integral / IWL_MVM_TT_INTEGRAL_DIV;
+
+	return min(backoff, params->tx_backoff[TT_TX_BACKOFF_SIZE - 1].backoff);
+}
+
+void iwl_mvm_tt_stats_update(struct iwl_mvm *mvm)
+{
+	struct iwl_mvm_tt_mgmt *tt = &mvm->thermal_throttle;
+	struct iwl_mvm_tt_stats *stats = &tt->stats;
+	unsigned long now = jiffies;
+	u32 ms = jiffies_to_msecs(now - stats->last_update);
+
+	stats->last_update = now;
+
+	if (tt->tx_backoff > tt->min_backoff) {
+		stats->backoff_ms += ms;
+		stats->lost_ms += div_u64((u64)ms * tt->tx_backoff,
+					  tt->tx_backoff + IWL_MVM_TT_TXOP_US);
+	}
+
+#ifdef CONFIG_THERMAL
+	if (mvm->cooling_dev.cur_state)
+		stats->ctdp_ms += ms;
+#endif
+}
+
 void iwl_mvm_enter_ctkill(struct iwl_mvm *mvm)
 {
 	struct iwl_mvm_tt_mgmt *tt = &mvm->thermal_throttle;
@@ -374,6 +491,8 @@ void iwl_mvm_tt_tx_backoff(struct iwl_mvm *mvm, u32 backoff)
 	if (iwl_mvm_send_cmd(mvm, &cmd) == 0) {
 		IWL_DEBUG_TEMP(mvm, "Set Thermal Tx backoff to: %u\n",
 			       backoff);
+		iwl_mvm_tt_stats_update(mvm);
+		mvm->thermal_throttle.stats.changes++;
 		mvm->thermal_throttle.tx_backoff = backoff;
 	} else {
 		IWL_ERR(mvm, "Failed to change Thermal Tx backoff\n");
@@ -391,6 +510,8 @@ void iwl_mvm_tt_handler(struct iwl_mvm *mvm)
 
 	IWL_DEBUG_TEMP(mvm, "NIC temperature: %d\n", mvm->temperature);
 
+	iwl_mvm_tt_trend_update(mvm, temperature);
+
 	if (params->support_ct_kill && temperature >= params->ct_kill_entry) {
 		iwl_mvm_enter_ctkill(mvm);
 		return;
@@ -442,6 +563,19 @@ void iwl_mvm_tt_handler(struct iwl_mvm *mvm)
 			tx_backoff = max(tt->min_backoff,
 					 params->tx_backoff[i].backoff);
 		}
+		if (tt->predictive) {
+			u32 predicted = iwl_mvm_tt_predict_backoff(mvm,
+								   temperature);
+
+			if (predicted > tx_backoff) {
+				IWL_DEBUG_TEMP(mvm,
+					       "Predictive Tx backoff %u (slope %d mC/s)\n",
+					       predicted, tt->trend.slope);
+				if (tt->tx_backoff != predicted)
+					tt->stats.early++;
+				tx_backoff = predicted;
+			}
+		}
 		if (tx_backoff != tt->min_backoff)
 			throttle_enable = true;
 		if (tt->tx_backoff != tx_backoff)
@@ -533,6 +667,7 @@ int iwl_mvm_ctdp_command(struct iwl_mvm *mvm, u32 op, u32 state)
 	switch (op) {
 	case CTDP_CMD_OPERATION_START:
 #ifdef CONFIG_THERMAL
+		iwl_mvm_tt_stats_update(mvm);
 		mvm->cooling_dev.cur_state = state;
 #endif /* CONFIG_THERMAL */
 		break;
@@ -635,6 +770,9 @@ static int iwl_mvm_tzone_get_temp(struct thermal_zone_device *device,
 	if (ret)
 		goto out;
 
+	/* keep the trend current for devices that throttle in firmware */
+	iwl_mvm_tt_trend_update(mvm, temp);
+
 	*temperature = temp * 1000;
 
 out:
@@ -887,6 +1025,10 @@ void iwl_mvm_thermal_initialize(struct iwl_mvm *mvm, u32 min_backoff)
 	tt->throttle = false;
 	tt->dynamic_smps = false;
 	tt->min_backoff = min_backoff;
+	tt->predictive = true;
+	memset(&tt->trend, 0, sizeof(tt->trend));
+	memset(&tt->stats, 0, sizeof(tt->stats));
+	tt->stats.last_update = jiffies;
 	INIT_DELAYED_WORK(&tt->ct_kill_exit, check_exit_ctkill);
 
 #ifdef CONFIG_THERMAL
@@ -135,6 +135,96 @@ int iwl_mvm_send_cmd_pdu_status(struct iwl_mvm *mvm, u32 id, u16 len,
 	return iwl_mvm_send_cmd_status(mvm, &cmd, status);
 }
 
+void iwl_mvm_cmd_batch_init(struct iwl_mvm *mvm,
+			    struct iwl_mvm_cmd_batch *batch)
+{
+	lockdep_assert_held(&mvm->mutex);
+
+	memset(batch, 0, sizeof(*batch));
+	batch->mvm = mvm;
+}
+
+/*
+ * Queue a command of the batch. The command data is copied by the
+ * transport, so it doesn't have to outlive this call. Returns the first
+ * error of the batch, once a command failed the following ones are
+ * dropped.
+ */
+int iwl_mvm_cmd_batch_add(struct iwl_mvm_cmd_batch *batch,
+			  struct iwl_host_cmd *cmd)
+{
+	if (batch->ret)
+		return batch->ret;
+
+	if (WARN_ONCE(cmd->flags & CMD_WANT_SKB, "cmd flags %x", cmd->flags)) {
+		batch->ret = -EINVAL;
+		return batch->ret;
+	}
+
+	if (!batch->n_cmds)
+		batch->start = ktime_get();
+
+	cmd->flags |= CMD_ASYNC;
+	batch->ret = iwl_mvm_send_cmd(batch->mvm, cmd);
+	if (!batch->ret)
+		batch->n_cmds++;
+
+	return batch->ret;
+}
+
+/*
+ * Send a command through @batch if there is one, otherwise synchronously
+ * as iwl_mvm_send_cmd_pdu() would.
+ */
+int iwl_mvm_cmd_batch_send_pdu(struct iwl_mvm *mvm,
+			       struct iwl_mvm_cmd_batch *batch,
+			       u32 id, u32 flags, u16 len, const void *data)
+{
+	struct iwl_host_cmd cmd = {
+		.id = id,
+		.len = { len, },
+		.data = { data, },
+		.flags = flags,
+	};
+
+	if (!batch)
+		return iwl_mvm_send_cmd(mvm, &cmd);
+
+	return iwl_mvm_cmd_batch_add(batch, &cmd);
+}
+
+/*
+ * Wait until the firmware handled all the commands of the batch and
+ * return the first error. Nothing is sent if the batch is empty.
+ */
+int iwl_mvm_cmd_batch_finish(struct iwl_mvm_cmd_batch *batch)
+{
+	struct iwl_mvm *mvm = batch->mvm;
+	struct iwl_mvm_cmd_batch_stats *stats = &mvm->cmd_batch_stats;
+	int ret;
+	u32 us;
+
+	if (!batch->n_cmds)
+		return batch->ret;
+
+	ret = iwl_mvm_send_cmd_pdu(mvm, ECHO_CMD, 0, 0, NULL);
+	if (!batch->ret)
+		batch->ret = ret;
+
+	us = ktime_us_delta(ktime_get(), batch->start);
+	stats->batches++;
+	stats->cmds += batch->n_cmds;
+	stats->last_us = us;
+	stats->max_us = max(stats->max_us, us);
+
+	IWL_DEBUG_INFO(mvm, "cmd batch: %d commands done in %u us (%d)\n",
+		       batch->n_cmds, us, batch->ret);
+
+	batch->n_cmds = 0;
+
+	return batch->ret;
+}
+
 int iwl_mvm_legacy_hw_idx_to_mac80211_idx(u32 rate_n_flags,
 					  enum nl80211_band band)
 {
@@ -13,7 +13,11 @@
 #include <linux/wait.h>
 #include <linux/pci.h>
 #include <linux/timer.h>
+#include <linux/hrtimer.h>
 #include <linux/cpu.h>
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+#include <net/page_pool.h>
+#endif
 
 #include "iwl-fh.h"
 #include "iwl-csr.h"
@@ -42,6 +46,7 @@ struct iwl_host_cmd;
  * struct iwl_rx_mem_buffer
  * @page_dma: bus address of rxb page
  * @page: driver's pointer to the rxb page
+ * @page_pool: page_pool the page was taken from, if any
  * @list: list entry for the membuffer
  * @invalid: rxb is in driver ownership - not owned by HW
  * @vid: index of this rxb in the global table
@@ -51,6 +56,9 @@ struct iwl_host_cmd;
 struct iwl_rx_mem_buffer {
 	dma_addr_t page_dma;
 	struct page *page;
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	struct page_pool *page_pool;
+#endif
 	struct list_head list;
 	u32 offset;
 	u16 vid;
@@ -75,6 +83,50 @@ struct isr_statistics {
 	u32 unhandled;
 };
 
+/*
+ * Software interrupt moderation for the non MSI-X (ICT) path: above
+ * IWL_PCIE_IRQ_MOD_LOW_PPS packets per second the interrupts stay masked
+ * for a window after each RX poll, growing linearly to the configured
+ * maximum at IWL_PCIE_IRQ_MOD_HIGH_PPS. Rates are measured every
+ * IWL_PCIE_IRQ_MOD_PERIOD.
+ */
+#define IWL_PCIE_IRQ_MOD_MAX_US		250
+#define IWL_PCIE_IRQ_MOD_LOW_PPS	4000
+#define IWL_PCIE_IRQ_MOD_HIGH_PPS	40000
+#define IWL_PCIE_IRQ_MOD_PERIOD		(HZ / 10)
+
+/**
+ * struct iwl_pcie_irq_mod - software interrupt moderation state
+ * @timer: ends the coalescing window by scheduling the RX NAPI again
+ * @max_us: largest coalescing window, 0 disables the moderation
+ * @window_us: coalescing window used for the current period
+ * @deferred: interrupts are kept masked until the next poll completes
+ * @period_start: jiffies the current measurement period started
+ * @irqs: interrupts in the current period
+ * @pkts: RX buffers handled in the current period
+ * @last_tx: TX frame counter at the start of the current period
+ * @irq_rate: interrupts per second over the last period
+ * @pkt_rate: RX buffers plus TX frames per second over the last period
+ * @irqs_total: interrupts handled
+ * @pkts_total: RX buffers plus TX frames handled
+ * @windows: coalescing windows armed
+ */
+struct iwl_pcie_irq_mod {
+	struct hrtimer timer;
+	u32 max_us;
+	u32 window_us;
+	bool deferred;
+	unsigned long period_start;
+	u32 irqs;
+	u32 pkts;
+	u64 last_tx;
+	u32 irq_rate;
+	u32 pkt_rate;
+	u64 irqs_total;
+	u64 pkts_total;
+	u64 windows;
+};
+
 /**
  * struct iwl_rx_transfer_desc - transfer descriptor
  * @addr: ptr to free buffer start address
@@ -103,6 +155,39 @@ struct iwl_rx_completion_desc {
 	u8 reserved2[25];
 } __packed;
 
+/**
+ * struct iwl_rxq_pp_stats - page pool RX statistics
+ * @alloc: RBs that got a buffer from the page pool
+ * @refill_miss: page pool allocations that failed while refilling
+ * @reuse: RBs that were handed back to the device without remapping
+ * @stolen: RB pages that were passed up to the stack
+ * @recycle: stolen pages that were already released when the RB was done,
+ *	and went straight back into the page pool cache
+ */
+struct iwl_rxq_pp_stats {
+	u64 alloc;
+	u64 refill_miss;
+	u64 reuse;
+	u64 stolen;
+	u64 recycle;
+};
+
+/**
+ * struct iwl_rxq_stats - per RX queue processing counters
+ * @irqs: MSI-X interrupts taken for the queue
+ * @polls: NAPI polls run for the queue
+ * @full_polls: polls that used up their whole budget
+ * @rbs: receive buffers handled
+ * @last_cpu: CPU that last processed the queue
+ */
+struct iwl_rxq_stats {
+	u64 irqs;
+	u64 polls;
+	u64 full_polls;
+	u64 rbs;
+	int last_cpu;
+};
+
 /**
  * struct iwl_rxq - Rx queue
  * @id: queue index
@@ -126,6 +211,10 @@ struct iwl_rx_completion_desc {
  * @queue: actual rx queue. Not used for multi-rx queue.
  * @next_rb_is_fragment: indicates that the previous RB that we handled set
  *	the fragmented flag, so the next one is still another fragment
+ * @page_pool: DMA-mapped page pool the queue refills its RBs from, if
+ *	the RBs fit into a single page
+ * @pp_stats: page pool statistics, see &struct iwl_rxq_pp_stats
+ * @stats: processing counters, see &struct iwl_rxq_stats
  *
  * NOTE:  rx_free and rx_used are used as a FIFO for iwl_rx_mem_buffers
  */
@@ -153,8 +242,22 @@ struct iwl_rxq {
 	spinlock_t lock;
 	struct napi_struct napi;
 	struct iwl_rx_mem_buffer *queue[RX_QUEUE_SIZE];
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	struct page_pool *page_pool;
+	struct iwl_rxq_pp_stats pp_stats;
+#endif
+	struct iwl_rxq_stats stats;
 };
 
+static inline bool iwl_pcie_rxq_has_page_pool(struct iwl_rxq *rxq)
+{
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	return rxq->page_pool;
+#else
+	return false;
+#endif
+}
+
 /**
  * struct iwl_rb_allocator - Rx allocator
  * @req_pending: number of requests the allcator had not processed yet
@@ -349,6 +452,7 @@ struct iwl_trans_pcie {
 	bool is_down, opmode_down;
 	s8 debug_rfkill;
 	struct isr_statistics isr_stats;
+	struct iwl_pcie_irq_mod irq_mod;
 
 	spinlock_t irq_lock;
 	struct mutex mutex;
@@ -719,6 +823,8 @@ static inline void iwl_enable_rfkill_int(struct iwl_trans *trans)
 }
 
 void iwl_pcie_handle_rfkill_irq(struct iwl_trans *trans);
+void iwl_pcie_irq_mod_init(struct iwl_trans *trans);
+void iwl_pcie_irq_mod_stop(struct iwl_trans *trans);
 
 static inline bool iwl_is_rfkill_set(struct iwl_trans *trans)
 {
@@ -111,6 +111,16 @@
  * rxq.queue -> rxq.rx_free -> rxq.queue
  * ...
  *
+ * Page pool:
+ * When the RBs fit into a single page each queue owns a DMA-mapped
+ * page_pool and the allocator isn't used. Used RBDs stay on the queue's
+ * rx_used list and are refilled from the page pool directly in NAPI,
+ * every RX_CLAIM_REQ_ALLOC RBs and when the poll is done:
+ * rxq.queue -> rxq.rx_used -> rxq.rx_free -> rxq.queue
+ * Pages that weren't stolen are only synced and reused, stolen pages are
+ * released back to the page pool, which recycles them if the stack is
+ * already done with them.
+ *
  */
 
 /*
@@ -387,6 +397,7 @@ static struct page *iwl_pcie_rx_alloc_page(struct iwl_trans *trans,
 	/* Alloc a new receive buffer */
 	page = alloc_pages(gfp_mask, trans_pcie->rx_page_order);
 	if (!page) {
+		iwl_trans_tpt_inc(trans, IWL_TPT_RB_REFILL_MISS);
 		if (net_ratelimit())
 			IWL_DEBUG_INFO(trans, "alloc_pages failed, order: %d\n",
 				       trans_pcie->rx_page_order);
@@ -414,6 +425,128 @@ static struct page *iwl_pcie_rx_alloc_page(struct iwl_trans *trans,
 	return page;
 }
 
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+static int iwl_pcie_rxq_create_page_pool(struct iwl_trans *trans,
+					 struct iwl_rxq *rxq)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	struct page_pool_params pp_params = {
+		.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV,
+		.order = 0,
+		.pool_size = rxq->queue_size,
+		.nid = dev_to_node(trans->dev),
+		.dev = trans->dev,
+		.dma_dir = DMA_FROM_DEVICE,
+		.offset = 0,
+		.max_len = PAGE_SIZE,
+	};
+	struct page_pool *pool;
+
+	/* split the pages if more than one RB fits */
+	if (trans_pcie->rx_buf_bytes < PAGE_SIZE)
+		pp_params.flags |= PP_FLAG_PAGE_FRAG;
+
+	pool = page_pool_create(&pp_params);
+	if (IS_ERR(pool))
+		return PTR_ERR(pool);
+
+	rxq->page_pool = pool;
+	memset(&rxq->pp_stats, 0, sizeof(rxq->pp_stats));
+
+	return 0;
+}
+
+/*
+ * iwl_pcie_rx_pp_alloc - take a (premapped) RB from the queue's page pool
+ *
+ * Must be called from the context that owns the queue, i.e. its NAPI
+ * or the init flow before the queue is running.
+ */
+static struct page *iwl_pcie_rx_pp_alloc(struct iwl_trans *trans,
+					 struct iwl_rxq *rxq,
+					 struct iwl_rx_mem_buffer *rxb,
+					 gfp_t priority)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	unsigned int offset = 0;
+	struct page *page;
+
+	if (trans_pcie->rx_buf_bytes < PAGE_SIZE)
+		page = page_pool_alloc_frag(rxq->page_pool, &offset,
+					    trans_pcie->rx_buf_bytes,
+					    priority);
+	else
+		page = page_pool_alloc_pages(rxq->page_pool, priority);
+
+	if (!page) {
+		rxq->pp_stats.refill_miss++;
+		iwl_trans_tpt_inc(trans, IWL_TPT_RB_REFILL_MISS);
+		return NULL;
+	}
+
+	rxb->page_pool = rxq->page_pool;
+	rxb->offset = offset;
+	rxb->page_dma = page_pool_get_dma_addr(page) + offset;
+	rxq->pp_stats.alloc++;
+
+	return page;
+}
+
+static void iwl_pcie_rxq_pp_alloc_rbs(struct iwl_trans *trans,
+				      gfp_t priority, struct iwl_rxq *rxq)
+{
+	struct iwl_rx_mem_buffer *rxb;
+	struct page *page;
+
+	while (1) {
+		spin_lock_bh(&rxq->lock);
+		if (list_empty(&rxq->rx_used)) {
+			spin_unlock_bh(&rxq->lock);
+			return;
+		}
+		rxb = list_first_entry(&rxq->rx_used, struct iwl_rx_mem_buffer,
+				       list);
+		list_del(&rxb->list);
+		spin_unlock_bh(&rxq->lock);
+
+		BUG_ON(rxb->page);
+		page = iwl_pcie_rx_pp_alloc(trans, rxq, rxb, priority);
+
+		spin_lock_bh(&rxq->lock);
+		if (!page) {
+			list_add(&rxb->list, &rxq->rx_used);
+			spin_unlock_bh(&rxq->lock);
+			return;
+		}
+		rxb->page = page;
+		list_add_tail(&rxb->list, &rxq->rx_free);
+		rxq->free_count++;
+		spin_unlock_bh(&rxq->lock);
+	}
+}
+
+/*
+ * iwl_pcie_rx_pp_put - return the driver's reference of a page pool RB
+ */
+static void iwl_pcie_rx_pp_put(struct iwl_rxq *rxq,
+			       struct iwl_rx_mem_buffer *rxb)
+{
+	/*
+	 * Only the queue that owns the page pool may recycle into its
+	 * lockless cache, RBs that completed on another queue go through
+	 * the pool's ring.
+	 */
+	bool direct = rxb->page_pool == rxq->page_pool;
+
+	if (direct && page_ref_count(rxb->page) == 1)
+		rxq->pp_stats.recycle++;
+
+	page_pool_put_full_page(rxb->page_pool, rxb->page, direct);
+	rxb->page = NULL;
+	rxb->page_pool = NULL;
+}
+#endif /* CPTCFG_IWLWIFI_PCIE_PAGE_POOL */
+
 /*
  * iwl_pcie_rxq_alloc_rbs - allocate a page for each used RBD
  *
@@ -430,6 +563,13 @@ void iwl_pcie_rxq_alloc_rbs(struct iwl_trans *trans, gfp_t priority,
 	struct iwl_rx_mem_buffer *rxb;
 	struct page *page;
 
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	if (iwl_pcie_rxq_has_page_pool(rxq)) {
+		iwl_pcie_rxq_pp_alloc_rbs(trans, priority, rxq);
+		return;
+	}
+#endif
+
 	while (1) {
 		unsigned int offset;
 
@@ -493,6 +633,16 @@ void iwl_pcie_free_rbs_pool(struct iwl_trans *trans)
 	for (i = 0; i < RX_POOL_SIZE(trans_pcie->num_rx_bufs); i++) {
 		if (!trans_pcie->rx_pool[i].page)
 			continue;
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+		if (trans_pcie->rx_pool[i].page_pool) {
+			page_pool_put_full_page(trans_pcie->rx_pool[i].page_pool,
+						trans_pcie->rx_pool[i].page,
+						false);
+			trans_pcie->rx_pool[i].page_pool = NULL;
+			trans_pcie->rx_pool[i].page = NULL;
+			continue;
+		}
+#endif
 		dma_unmap_page(trans->dev, trans_pcie->rx_pool[i].page_dma,
 			       trans_pcie->rx_buf_bytes, DMA_FROM_DEVICE);
 		__free_pages(trans_pcie->rx_pool[i].page,
@@ -793,10 +943,24 @@ static int iwl_pcie_rx_alloc(struct iwl_trans *trans)
 		ret = iwl_pcie_alloc_rxq_dma(trans, rxq);
 		if (ret)
 			goto err;
+
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+		if (!trans_pcie->rx_page_order) {
+			ret = iwl_pcie_rxq_create_page_pool(trans, rxq);
+			if (ret)
+				goto err;
+		}
+#endif
 	}
 	return 0;
 
 err:
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	for (i = 0; i < trans->num_rx_queues; i++) {
+		if (trans_pcie->rxq[i].page_pool)
+			page_pool_destroy(trans_pcie->rxq[i].page_pool);
+	}
+#endif
 	if (trans_pcie->base_rb_stts) {
 		dma_free_coherent(trans->dev,
 				  rb_stts_size * trans->num_rx_queues,
@@ -983,22 +1147,148 @@ void iwl_pcie_rx_init_rxb_lists(struct iwl_rxq *rxq)
 
 static int iwl_pcie_rx_handle(struct iwl_trans *trans, int queue, int budget);
 
+static void iwl_pcie_rx_tpt_poll(struct iwl_trans *trans, int handled,
+				 u64 start)
+{
+	iwl_trans_tpt_inc(trans, IWL_TPT_RX_POLLS);
+	iwl_trans_tpt_add(trans, IWL_TPT_RX_RBS, handled);
+	iwl_trans_tpt_hist(trans, IWL_TPT_HIST_RX_POLL_NS,
+			   ktime_get_ns() - start);
+}
+
+static enum hrtimer_restart iwl_pcie_irq_mod_timer(struct hrtimer *timer)
+{
+	struct iwl_trans_pcie *trans_pcie =
+		container_of(timer, struct iwl_trans_pcie, irq_mod.timer);
+
+	/* the poll picks up what arrived and unmasks the interrupts */
+	napi_schedule(&trans_pcie->rxq[0].napi);
+
+	return HRTIMER_NORESTART;
+}
+
+void iwl_pcie_irq_mod_init(struct iwl_trans *trans)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	struct iwl_pcie_irq_mod *mod = &trans_pcie->irq_mod;
+
+	hrtimer_init(&mod->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	mod->timer.function = iwl_pcie_irq_mod_timer;
+	mod->max_us = IWL_PCIE_IRQ_MOD_MAX_US;
+	mod->period_start = jiffies;
+}
+
+void iwl_pcie_irq_mod_stop(struct iwl_trans *trans)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+
+	hrtimer_cancel(&trans_pcie->irq_mod.timer);
+	trans_pcie->irq_mod.deferred = false;
+}
+
+static u64 iwl_pcie_irq_mod_tx_frames(struct iwl_trans *trans)
+{
+	u64 frames = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		frames += per_cpu_ptr(trans->tpt, cpu)->counters[IWL_TPT_TX_FRAMES];
+
+	return frames;
+}
+
+/*
+ * Account a completed RX poll and return the window the interrupts
+ * should stay masked for, 0 to unmask them right away. At most one window
+ * follows each interrupt: the poll run by the timer always unmasks.
+ */
+static u32 iwl_pcie_irq_mod_poll_done(struct iwl_trans *trans, int handled)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	struct iwl_pcie_irq_mod *mod = &trans_pcie->irq_mod;
+	unsigned long elapsed = jiffies - mod->period_start;
+
+	if (elapsed >= IWL_PCIE_IRQ_MOD_PERIOD) {
+		u64 tx = iwl_pcie_irq_mod_tx_frames(trans);
+		u32 irqs = READ_ONCE(mod->irqs);
+		u64 pkts = mod->pkts + (tx - mod->last_tx);
+		u32 max_us = READ_ONCE(mod->max_us);
+
+		mod->irq_rate = div_u64((u64)irqs * HZ, elapsed);
+		mod->pkt_rate = div_u64(pkts * HZ, elapsed);
+		mod->irqs_total += irqs;
+		mod->pkts_total += pkts;
+
+		if (!max_us || mod->pkt_rate <= IWL_PCIE_IRQ_MOD_LOW_PPS)
+			mod->window_us = 0;
+		else if (mod->pkt_rate >= IWL_PCIE_IRQ_MOD_HIGH_PPS)
+			mod->window_us = max_us;
+		else
+			mod->window_us = max_us *
+				(mod->pkt_rate - IWL_PCIE_IRQ_MOD_LOW_PPS) /
+				(IWL_PCIE_IRQ_MOD_HIGH_PPS -
+				 IWL_PCIE_IRQ_MOD_LOW_PPS);
+
+		WRITE_ONCE(mod->irqs, 0);
+		mod->pkts = 0;
+		mod->last_tx = tx;
+		mod->period_start = jiffies;
+	}
+
+	if (mod->deferred) {
+		mod->deferred = false;
+		return 0;
+	}
+
+	if (!mod->window_us || !handled)
+		return 0;
+
+	mod->deferred = true;
+	mod->windows++;
+
+	return mod->window_us;
+}
+
 static int iwl_pcie_napi_poll(struct napi_struct *napi, int budget)
 {
 	struct iwl_rxq *rxq = container_of(napi, struct iwl_rxq, napi);
 	struct iwl_trans_pcie *trans_pcie;
 	struct iwl_trans *trans;
+	u64 start;
 	int ret;
 
 	trans_pcie = container_of(napi->dev, struct iwl_trans_pcie, napi_dev);
 	trans = trans_pcie->trans;
 
+	start = ktime_get_ns();
 	ret = iwl_pcie_rx_handle(trans, rxq->id, budget);
+	iwl_pcie_rx_tpt_poll(trans, ret, start);
+	trans_pcie->irq_mod.pkts += ret;
 
 	IWL_DEBUG_ISR(trans, "[%d] handled %d, budget %d\n",
 		      rxq->id, ret, budget);
 
+	rxq->stats.polls++;
+	rxq->stats.last_cpu = smp_processor_id();
+	if (ret >= budget)
+		rxq->stats.full_polls++;
+
 	if (ret < budget) {
+		u32 window_us = iwl_pcie_irq_mod_poll_done(trans, ret);
+
+		/*
+		 * Keep the interrupts masked for the coalescing window, the
+		 * timer polls again and that poll unmasks them. Arm it only
+		 * once NAPI is complete so it can always be rescheduled.
+		 */
+		if (window_us) {
+			if (napi_complete_done(&rxq->napi, ret))
+				hrtimer_start(&trans_pcie->irq_mod.timer,
+					      us_to_ktime(window_us),
+					      HRTIMER_MODE_REL);
+			return ret;
+		}
+
 		spin_lock(&trans_pcie->irq_lock);
 		if (test_bit(STATUS_INT_ENABLED, &trans->status))
 			_iwl_enable_interrupts(trans);
@@ -1015,15 +1305,23 @@ static int iwl_pcie_napi_poll_msix(struct napi_struct *napi, int budget)
 	struct iwl_rxq *rxq = container_of(napi, struct iwl_rxq, napi);
 	struct iwl_trans_pcie *trans_pcie;
 	struct iwl_trans *trans;
+	u64 start;
 	int ret;
 
 	trans_pcie = container_of(napi->dev, struct iwl_trans_pcie, napi_dev);
 	trans = trans_pcie->trans;
 
+	start = ktime_get_ns();
 	ret = iwl_pcie_rx_handle(trans, rxq->id, budget);
+	iwl_pcie_rx_tpt_poll(trans, ret, start);
 	IWL_DEBUG_ISR(trans, "[%d] handled %d, budget %d\n", rxq->id, ret,
 		      budget);
 
+	rxq->stats.polls++;
+	rxq->stats.last_cpu = smp_processor_id();
+	if (ret >= budget)
+		rxq->stats.full_polls++;
+
 	if (ret < budget) {
 		int irq_line = rxq->id;
 
@@ -1113,10 +1411,14 @@ static int _iwl_pcie_rx_init(struct iwl_trans *trans)
 	for (i = 0; i < num_alloc; i++) {
 		struct iwl_rx_mem_buffer *rxb = &trans_pcie->rx_pool[i];
 
-		if (i < allocator_pool_size)
-			list_add(&rxb->list, &rba->rbd_empty);
-		else
+		if (i >= allocator_pool_size)
 			list_add(&rxb->list, &def_rxq->rx_used);
+		else if (iwl_pcie_rxq_has_page_pool(def_rxq))
+			/* no allocator - the queues keep the spare RBDs */
+			list_add(&rxb->list,
+				 &trans_pcie->rxq[i % trans->num_rx_queues].rx_used);
+		else
+			list_add(&rxb->list, &rba->rbd_empty);
 		trans_pcie->global_table[i] = rxb;
 		rxb->vid = (u16)(i + 1);
 		rxb->invalid = true;
@@ -1124,6 +1426,14 @@ static int _iwl_pcie_rx_init(struct iwl_trans *trans)
 
 	iwl_pcie_rxq_alloc_rbs(trans, GFP_KERNEL, def_rxq);
 
+	/* page pool queues got their share of the spare RBDs as well */
+	for (i = 1; i < trans->num_rx_queues; i++) {
+		struct iwl_rxq *rxq = &trans_pcie->rxq[i];
+
+		if (iwl_pcie_rxq_has_page_pool(rxq))
+			iwl_pcie_rxq_alloc_rbs(trans, GFP_KERNEL, rxq);
+	}
+
 	return 0;
 }
 
@@ -1201,7 +1511,17 @@ void iwl_pcie_rx_free(struct iwl_trans *trans)
 			napi_disable(&rxq->napi);
 			netif_napi_del(&rxq->napi);
 		}
+
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+		if (rxq->page_pool)
+			page_pool_destroy(rxq->page_pool);
+		rxq->page_pool = NULL;
+#endif
 	}
+
+	/* NAPI is disabled, the timer can't schedule it anymore */
+	iwl_pcie_irq_mod_stop(trans);
+
 	kfree(trans_pcie->rx_pool);
 	kfree(trans_pcie->global_table);
 	kfree(trans_pcie->rxq);
@@ -1238,6 +1558,10 @@ static void iwl_pcie_rx_reuse_rbd(struct iwl_trans *trans,
 	if (unlikely(emergency))
 		return;
 
+	/* page pool queues refill themselves from NAPI */
+	if (iwl_pcie_rxq_has_page_pool(rxq))
+		return;
+
 	/* Count the allocator owned RBDs */
 	rxq->used_count++;
 
@@ -1271,6 +1595,12 @@ static void iwl_pcie_rx_handle_rb(struct iwl_trans *trans,
 	if (WARN_ON(!rxb))
 		return;
 
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	if (rxb->page_pool)
+		dma_sync_single_for_cpu(trans->dev, rxb->page_dma, max_len,
+					DMA_FROM_DEVICE);
+	else
+#endif
 	dma_unmap_page(trans->dev, rxb->page_dma, max_len, DMA_FROM_DEVICE);
 
 	while (offset + sizeof(u32) + sizeof(struct iwl_cmd_header) < max_len) {
@@ -1377,6 +1707,24 @@ static void iwl_pcie_rx_handle_rb(struct iwl_trans *trans,
 			break;
 	}
 
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	if (rxb->page_pool) {
+		if (page_stolen) {
+			rxq->pp_stats.stolen++;
+			iwl_pcie_rx_pp_put(rxq, rxb);
+			iwl_pcie_rx_reuse_rbd(trans, rxb, rxq, emergency);
+		} else {
+			/* still mapped, just give it back to the device */
+			dma_sync_single_for_device(trans->dev, rxb->page_dma,
+						   max_len, DMA_FROM_DEVICE);
+			list_add_tail(&rxb->list, &rxq->rx_free);
+			rxq->free_count++;
+			rxq->pp_stats.reuse++;
+		}
+		return;
+	}
+#endif
+
 	/* page was stolen from us -- free our reference */
 	if (page_stolen) {
 		__free_pages(rxb->page, trans_pcie->rx_page_order);
@@ -1522,9 +1870,23 @@ restart:
 		} else {
 			iwl_pcie_rx_handle_rb(trans, rxq, rxb, emergency, i);
 		}
+		rxq->stats.rbs++;
 
 		i = (i + 1) & (rxq->queue_size - 1);
 
+		if (iwl_pcie_rxq_has_page_pool(rxq)) {
+			/* refill from the page pool every few RBs */
+			if (++count == RX_CLAIM_REQ_ALLOC) {
+				count = 0;
+				rxq->read = i;
+				spin_unlock(&rxq->lock);
+				iwl_pcie_rxq_alloc_rbs(trans, GFP_ATOMIC, rxq);
+				iwl_pcie_rxq_restock(trans, rxq);
+				goto restart;
+			}
+			continue;
+		}
+
 		/*
 		 * If we have RX_CLAIM_REQ_ALLOC released rx buffers -
 		 * try to claim the pre-allocated buffers from the allocator.
@@ -1574,11 +1936,13 @@ out:
 	 * by allocating them here, they are now in the queue free list, and
 	 * will be restocked by the next call of iwl_pcie_rxq_restock.
 	 */
-	if (unlikely(emergency && count))
+	if (unlikely(emergency && count) || iwl_pcie_rxq_has_page_pool(rxq))
 		iwl_pcie_rxq_alloc_rbs(trans, GFP_ATOMIC, rxq);
 
 	iwl_pcie_rxq_restock(trans, rxq);
 
+	iwl_op_mode_rx_done(trans->op_mode, &rxq->napi, rxq->id);
+
 	return handled;
 }
 
@@ -1614,6 +1978,8 @@ irqreturn_t iwl_pcie_irq_rx_msix_handler(int irq, void *dev_id)
 	lock_map_acquire(&trans->sync_cmd_lockdep_map);
 	IWL_DEBUG_ISR(trans, "[%d] Got interrupt\n", entry->entry);
 
+	rxq->stats.irqs++;
+
 	local_bh_disable();
 	if (napi_schedule_prep(&rxq->napi))
 		__napi_schedule(&rxq->napi);
@@ -1631,8 +1997,6 @@ irqreturn_t iwl_pcie_irq_rx_msix_handler(int irq, void *dev_id)
  */
 static void iwl_pcie_irq_handle_error(struct iwl_trans *trans)
 {
-	int i;
-
 	/* W/A for WiFi/WiMAX coex and WiMAX own the RF */
 	if (trans->cfg->internal_wimax_coex &&
 	    !trans->cfg->apmg_not_supported &&
@@ -1646,11 +2010,7 @@ static void iwl_pcie_irq_handle_error(struct iwl_trans *trans)
 		return;
 	}
 
-	for (i = 0; i < trans->trans_cfg->base_params->num_of_queues; i++) {
-		if (!trans->txqs.txq[i])
-			continue;
-		del_timer(&trans->txqs.txq[i]->stuck_timer);
-	}
+	del_timer(&trans->txqs.stuck_timer);
 
 	/* The STATUS_FW_ERROR bit is set in this function. This must happen
 	 * before we wake up the command caller, to ensure a proper cleanup. */
@@ -1843,6 +2203,8 @@ irqreturn_t iwl_pcie_irq_handler(int irq, void *dev_id)
 		goto out;
 	}
 
+	WRITE_ONCE(trans_pcie->irq_mod.irqs, trans_pcie->irq_mod.irqs + 1);
+
 	/* Ack/clear/reset pending uCode interrupts.
 	 * Note:  Some bits in CSR_INT are "OR" of bits in CSR_FH_INT_STATUS,
 	 */
@@ -1349,6 +1349,7 @@ void iwl_pcie_synchronize_irqs(struct iwl_trans *trans)
 			synchronize_irq(trans_pcie->msix_entries[i].vector);
 	} else {
 		synchronize_irq(trans_pcie->pci_dev->irq);
+		iwl_pcie_irq_mod_stop(trans);
 	}
 }
 
@@ -1725,27 +1726,38 @@ enable_msi:
 	}
 }
 
+static int iwl_pcie_irq_set_vec_affinity(struct iwl_trans *trans, int vec,
+					 int cpu)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	int ret;
+
+	cpumask_clear(&trans_pcie->affinity_mask[vec]);
+	cpumask_set_cpu(cpu, &trans_pcie->affinity_mask[vec]);
+	ret = irq_set_affinity_hint(trans_pcie->msix_entries[vec].vector,
+				    &trans_pcie->affinity_mask[vec]);
+	if (ret)
+		IWL_ERR(trans, "Failed to set affinity mask for IRQ %d\n",
+			trans_pcie->msix_entries[vec].vector);
+	return ret;
+}
+
 static void iwl_pcie_irq_set_affinity(struct iwl_trans *trans)
 {
-	int iter_rx_q, i, ret, cpu, offset;
+	int iter_rx_q, i, cpu = -1;
 	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
 
 	i = trans_pcie->shared_vec_mask & IWL_SHARED_IRQ_FIRST_RSS ? 0 : 1;
 	iter_rx_q = trans_pcie->trans->num_rx_queues - 1 + i;
-	offset = 1 + i;
 	for (; i < iter_rx_q ; i++) {
 		/*
-		 * Get the cpu prior to the place to search
-		 * (i.e. return will be > i - 1).
+		 * Spread the RSS vectors over the online CPUs, wrapping
+		 * around if there are more queues than CPUs.
 		 */
-		cpu = cpumask_next(i - offset, cpu_online_mask);
-		cpumask_set_cpu(cpu, &trans_pcie->affinity_mask[i]);
-		ret = irq_set_affinity_hint(trans_pcie->msix_entries[i].vector,
-					    &trans_pcie->affinity_mask[i]);
-		if (ret)
-			IWL_ERR(trans_pcie->trans,
-				"Failed to set affinity mask for IRQ %d\n",
-				trans_pcie->msix_entries[i].vector);
+		cpu = cpumask_next(cpu, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first(cpu_online_mask);
+		iwl_pcie_irq_set_vec_affinity(trans, i, cpu);
 	}
 }
 
@@ -2604,14 +2616,22 @@ static int iwl_dbgfs_tx_queue_seq_show(struct seq_file *seq, void *v)
 		   (unsigned int)state->pos,
 		   !!test_bit(state->pos, trans->txqs.queue_used),
 		   !!test_bit(state->pos, trans->txqs.queue_stopped));
-	if (txq)
+	if (txq) {
 		seq_printf(seq,
 			   "read=%u write=%u need_update=%d frozen=%d n_window=%d ampdu=%d",
 			   txq->read_ptr, txq->write_ptr,
 			   txq->need_update, txq->frozen,
 			   txq->n_window, txq->ampdu);
-	else
+#ifdef CONFIG_BQL
+		if (txq->bql)
+			seq_printf(seq, " bql_limit=%u bql_inflight=%u",
+				   txq->dql.limit,
+				   txq->dql.num_queued -
+				   txq->dql.num_completed);
+#endif
+	} else {
 		seq_puts(seq, "(unallocated)");
+	}
 
 	if (state->pos == trans->txqs.cmd.q_id)
 		seq_puts(seq, " (HCMD)");
@@ -2651,7 +2671,10 @@ static ssize_t iwl_dbgfs_rx_queue_read(struct file *file,
 	int pos = 0, i, ret;
 	size_t bufsz;
 
-	bufsz = sizeof(char) * 121 * trans->num_rx_queues;
+	bufsz = sizeof(char) * 260 * trans->num_rx_queues;
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+	bufsz += sizeof(char) * 200 * trans->num_rx_queues;
+#endif
 
 	if (!trans_pcie->rxq)
 		return -EAGAIN;
@@ -2685,6 +2708,30 @@ static ssize_t iwl_dbgfs_rx_queue_read(struct file *file,
 			pos += scnprintf(buf + pos, bufsz - pos,
 					 "\tclosed_rb_num: Not Allocated\n");
 		}
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\tirqs: %llu polls: %llu full_polls: %llu\n",
+				 rxq->stats.irqs, rxq->stats.polls,
+				 rxq->stats.full_polls);
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "\trbs: %llu last_cpu: %d\n",
+				 rxq->stats.rbs, rxq->stats.last_cpu);
+#ifdef CPTCFG_IWLWIFI_PCIE_PAGE_POOL
+		if (rxq->page_pool) {
+			struct iwl_rxq_pp_stats *stats = &rxq->pp_stats;
+
+			pos += scnprintf(buf + pos, bufsz - pos,
+					 "\tpp_alloc: %llu\n", stats->alloc);
+			pos += scnprintf(buf + pos, bufsz - pos,
+					 "\tpp_refill_miss: %llu\n",
+					 stats->refill_miss);
+			pos += scnprintf(buf + pos, bufsz - pos,
+					 "\tpp_reuse: %llu\n", stats->reuse);
+			pos += scnprintf(buf + pos, bufsz - pos,
+					 "\tpp_stolen: %llu\n", stats->stolen);
+			pos += scnprintf(buf + pos, bufsz - pos,
+					 "\tpp_recycle: %llu\n", stats->recycle);
+		}
+#endif
 	}
 	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
 	kfree(buf);
@@ -2769,6 +2816,61 @@ static ssize_t iwl_dbgfs_interrupt_write(struct file *file,
 	return count;
 }
 
+static ssize_t iwl_dbgfs_irq_mod_read(struct file *file,
+				      char __user *user_buf,
+				      size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	struct iwl_pcie_irq_mod *mod = &trans_pcie->irq_mod;
+	u64 irqs_total = mod->irqs_total, pkts_total = mod->pkts_total;
+	char buf[320];
+	int pos = 0;
+
+	if (trans_pcie->msix_enabled)
+		return -EOPNOTSUPP;
+
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "max window: %u us\ncurrent window: %u us\n",
+			 READ_ONCE(mod->max_us), mod->window_us);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "interrupts/s: %u\npackets/s: %u\n",
+			 mod->irq_rate, mod->pkt_rate);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "interrupts: %llu\npackets: %llu\nwindows: %llu\n",
+			 irqs_total, pkts_total, mod->windows);
+	pos += scnprintf(buf + pos, sizeof(buf) - pos,
+			 "interrupts per 1000 packets: %llu\n",
+			 pkts_total ? div64_u64(irqs_total * 1000, pkts_total) :
+				      0);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+}
+
+/* sets the largest coalescing window in usecs, 0 disables moderation */
+static ssize_t iwl_dbgfs_irq_mod_write(struct file *file,
+				       const char __user *user_buf,
+				       size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	u32 max_us;
+	int ret;
+
+	if (trans_pcie->msix_enabled)
+		return -EOPNOTSUPP;
+
+	ret = kstrtou32_from_user(user_buf, count, 0, &max_us);
+	if (ret)
+		return ret;
+	if (max_us > USEC_PER_MSEC)
+		return -EINVAL;
+
+	WRITE_ONCE(trans_pcie->irq_mod.max_us, max_us);
+
+	return count;
+}
+
 static ssize_t iwl_dbgfs_csr_write(struct file *file,
 				   const char __user *user_buf,
 				   size_t count, loff_t *ppos)
@@ -2837,6 +2939,160 @@ static ssize_t iwl_dbgfs_rfkill_write(struct file *file,
 	return count;
 }
 
+static const char * const iwl_tpt_counter_names[IWL_TPT_NUM_COUNTERS] = {
+	[IWL_TPT_RX_POLLS] = "rx_polls",
+	[IWL_TPT_RX_RBS] = "rx_rbs",
+	[IWL_TPT_RB_REFILL_MISS] = "rb_refill_miss",
+	[IWL_TPT_TX_FRAMES] = "tx_frames",
+	[IWL_TPT_TX_RECLAIMED] = "tx_reclaimed",
+	[IWL_TPT_TX_STOPS] = "tx_stops",
+};
+
+static const char * const iwl_tpt_hist_names[IWL_TPT_NUM_HISTS] = {
+	[IWL_TPT_HIST_RX_POLL_NS] = "rx_poll_ns",
+	[IWL_TPT_HIST_TX_LATENCY_US] = "tx_latency_us",
+	[IWL_TPT_HIST_REORDER_HOLD_US] = "reorder_hold_us",
+	[IWL_TPT_HIST_TFD_USED] = "tfd_used",
+};
+
+/*
+ * One "counter <name> <value>" line per counter and one
+ * "hist <name> <bucket 0> ... <bucket 31>" line per log2 histogram, where
+ * bucket n counts values in [2^(n-1), 2^n). New entries are only ever
+ * appended, so parsers can rely on the names.
+ */
+static ssize_t iwl_dbgfs_tpt_stats_read(struct file *file,
+					char __user *user_buf,
+					size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	size_t bufsz = 64 * IWL_TPT_NUM_COUNTERS +
+		       (32 + 21 * IWL_TPT_HIST_BUCKETS) * IWL_TPT_NUM_HISTS;
+	struct iwl_tpt_stats *sum;
+	int pos = 0, i, j;
+	ssize_t ret;
+	char *buf;
+
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	sum = kmalloc(sizeof(*sum), GFP_KERNEL);
+	if (!buf || !sum) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	iwl_trans_tpt_sum(trans, sum);
+
+	for (i = 0; i < IWL_TPT_NUM_COUNTERS; i++)
+		pos += scnprintf(buf + pos, bufsz - pos, "counter %s %llu\n",
+				 iwl_tpt_counter_names[i], sum->counters[i]);
+
+	for (i = 0; i < IWL_TPT_NUM_HISTS; i++) {
+		pos += scnprintf(buf + pos, bufsz - pos, "hist %s",
+				 iwl_tpt_hist_names[i]);
+		for (j = 0; j < IWL_TPT_HIST_BUCKETS; j++)
+			pos += scnprintf(buf + pos, bufsz - pos, " %llu",
+					 sum->hist[i][j]);
+		pos += scnprintf(buf + pos, bufsz - pos, "\n");
+	}
+
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+out:
+	kfree(sum);
+	kfree(buf);
+
+	return ret;
+}
+
+/*
+ * Map an RX queue to its interrupt vector, matching iwl_pcie_map_rx_causes():
+ * when the first RSS queue shares the default vector, every RSS queue uses
+ * the vector before its own index. Returns -EINVAL if the queue has no
+ * allocated vector.
+ */
+static int iwl_pcie_rxq_to_vec(struct iwl_trans *trans, int queue)
+{
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	int vec = queue;
+
+	if (queue && trans_pcie->shared_vec_mask & IWL_SHARED_IRQ_FIRST_RSS)
+		vec = queue - 1;
+
+	if (vec < 0 || vec >= trans_pcie->alloc_vecs)
+		return -EINVAL;
+	return vec;
+}
+
+static ssize_t iwl_dbgfs_rx_affinity_read(struct file *file,
+					  char __user *user_buf,
+					  size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	size_t bufsz = 64 * IWL_MAX_RX_HW_QUEUES;
+	int pos = 0, i;
+	ssize_t ret;
+	char *buf;
+
+	if (!trans_pcie->msix_enabled)
+		return -EOPNOTSUPP;
+
+	buf = kzalloc(bufsz, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	for (i = 1; i < trans->num_rx_queues; i++) {
+		int vec = iwl_pcie_rxq_to_vec(trans, i);
+
+		if (vec < 0)
+			continue;
+		pos += scnprintf(buf + pos, bufsz - pos,
+				 "queue %d: irq %d cpus %*pbl\n", i,
+				 trans_pcie->msix_entries[vec].vector,
+				 cpumask_pr_args(&trans_pcie->affinity_mask[vec]));
+	}
+
+	ret = simple_read_from_buffer(user_buf, count, ppos, buf, pos);
+	kfree(buf);
+
+	return ret;
+}
+
+/* "<queue> <cpu>" pins the interrupt of an RSS queue to a CPU */
+static ssize_t iwl_dbgfs_rx_affinity_write(struct file *file,
+					   const char __user *user_buf,
+					   size_t count, loff_t *ppos)
+{
+	struct iwl_trans *trans = file->private_data;
+	struct iwl_trans_pcie *trans_pcie = IWL_TRANS_GET_PCIE_TRANS(trans);
+	unsigned int queue, cpu;
+	char buf[32] = {};
+	int vec, ret;
+
+	if (!trans_pcie->msix_enabled)
+		return -EOPNOTSUPP;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, user_buf, count))
+		return -EFAULT;
+
+	if (sscanf(buf, "%u %u", &queue, &cpu) != 2)
+		return -EINVAL;
+
+	/* queue 0 is the default queue, it follows the default vector */
+	if (!queue || queue >= trans->num_rx_queues ||
+	    cpu >= nr_cpu_ids || !cpu_online(cpu))
+		return -EINVAL;
+
+	vec = iwl_pcie_rxq_to_vec(trans, queue);
+	if (vec < 0)
+		return vec;
+
+	ret = iwl_pcie_irq_set_vec_affinity(trans, vec, cpu);
+
+	return ret ?: count;
+}
+
 static int iwl_dbgfs_monitor_data_open(struct inode *inode,
 				       struct file *file)
 {
@@ -2984,10 +3240,13 @@ static ssize_t iwl_dbgfs_rf_read(struct file *file,
 }
 
 DEBUGFS_READ_WRITE_FILE_OPS(interrupt);
+DEBUGFS_READ_WRITE_FILE_OPS(irq_mod);
 DEBUGFS_READ_FILE_OPS(fh_reg);
 DEBUGFS_READ_FILE_OPS(rx_queue);
 DEBUGFS_WRITE_FILE_OPS(csr);
 DEBUGFS_READ_WRITE_FILE_OPS(rfkill);
+DEBUGFS_READ_WRITE_FILE_OPS(rx_affinity);
+DEBUGFS_READ_FILE_OPS(tpt_stats);
 DEBUGFS_READ_FILE_OPS(rf);
 
 static const struct file_operations iwl_dbgfs_tx_queue_ops = {
@@ -3012,9 +3271,12 @@ void iwl_trans_pcie_dbgfs_register(struct iwl_trans *trans)
 	DEBUGFS_ADD_FILE(rx_queue, dir, 0400);
 	DEBUGFS_ADD_FILE(tx_queue, dir, 0400);
 	DEBUGFS_ADD_FILE(interrupt, dir, 0600);
+	DEBUGFS_ADD_FILE(irq_mod, dir, 0600);
 	DEBUGFS_ADD_FILE(csr, dir, 0200);
 	DEBUGFS_ADD_FILE(fh_reg, dir, 0400);
 	DEBUGFS_ADD_FILE(rfkill, dir, 0600);
+	DEBUGFS_ADD_FILE(rx_affinity, dir, 0600);
+	DEBUGFS_ADD_FILE(tpt_stats, dir, 0400);
 	DEBUGFS_ADD_FILE(monitor_data, dir, 0400);
 	DEBUGFS_ADD_FILE(rf, dir, 0400);
 }
@@ -3578,6 +3840,7 @@ struct iwl_trans *iwl_trans_pcie_alloc(struct pci_dev *pdev,
 	trans_pcie->trans = trans;
 	trans_pcie->opmode_down = true;
 	spin_lock_init(&trans_pcie->irq_lock);
+	iwl_pcie_irq_mod_init(trans);
 	spin_lock_init(&trans_pcie->reg_lock);
 	spin_lock_init(&trans_pcie->alloc_page_lock);
 	mutex_init(&trans_pcie->mutex);
@@ -240,9 +240,9 @@ int iwl_pcie_gen2_enqueue_hcmd(struct iwl_trans *trans,
 
 	trace_iwlwifi_dev_hcmd(trans->dev, cmd, cmd_size, &out_cmd->hdr_wide);
 
-	/* start timer if queue currently empty */
-	if (txq->read_ptr == txq->write_ptr && txq->wd_timeout)
-		mod_timer(&txq->stuck_timer, jiffies + txq->wd_timeout);
+	/* start the stuck check if queue currently empty */
+	if (txq->read_ptr == txq->write_ptr)
+		iwl_txq_start_stuck_check(trans, txq);
 
 	spin_lock(&trans_pcie->reg_lock);
 	/* Increment and update queue's write index */
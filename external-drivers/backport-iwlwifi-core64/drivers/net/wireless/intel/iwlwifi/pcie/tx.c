@@ -285,7 +285,7 @@ static void iwl_pcie_txq_free(struct iwl_trans *trans, int txq_id)
 	kfree(txq->entries);
 	txq->entries = NULL;
 
-	del_timer_sync(&txq->stuck_timer);
+	del_timer_sync(&trans->txqs.stuck_timer);
 
 	/* 0-fill queue descriptor structure */
 	memset(txq, 0, sizeof(*txq));
@@ -860,6 +860,7 @@ void iwl_trans_pcie_txq_disable(struct iwl_trans *trans, int txq_id,
 	static const u32 zero_val[4] = {};
 
 	trans->txqs.txq[txq_id]->frozen_expiry_remainder = 0;
+	trans->txqs.txq[txq_id]->stuck_deadline = 0;
 	trans->txqs.txq[txq_id]->frozen = false;
 
 	/*
@@ -1143,9 +1144,9 @@ int iwl_pcie_enqueue_hcmd(struct iwl_trans *trans,
 
 	trace_iwlwifi_dev_hcmd(trans->dev, cmd, cmd_size, &out_cmd->hdr_wide);
 
-	/* start timer if queue currently empty */
-	if (txq->read_ptr == txq->write_ptr && txq->wd_timeout)
-		mod_timer(&txq->stuck_timer, jiffies + txq->wd_timeout);
+	/* start the stuck check if queue currently empty */
+	if (txq->read_ptr == txq->write_ptr)
+		iwl_txq_start_stuck_check(trans, txq);
 
 	ret = iwl_pcie_set_cmd_in_flight(trans, cmd);
 	if (ret < 0) {
@@ -1501,6 +1502,7 @@ int iwl_trans_pcie_tx(struct iwl_trans *trans, struct sk_buff *skb,
 	/* Set up driver data for this TFD */
 	txq->entries[txq->write_ptr].skb = skb;
 	txq->entries[txq->write_ptr].cmd = dev_cmd;
+	iwl_txq_tpt_tx(trans, txq, txq->write_ptr);
 
 	dev_cmd->hdr.sequence =
 		cpu_to_le16((u16)(QUEUE_TO_SEQ(txq_id) |
@@ -1597,20 +1599,9 @@ int iwl_trans_pcie_tx(struct iwl_trans *trans, struct sk_buff *skb,
 
 	wait_write_ptr = ieee80211_has_morefrags(fc);
 
-	/* start timer if queue currently empty */
-	if (txq->read_ptr == txq->write_ptr && txq->wd_timeout) {
-		/*
-		 * If the TXQ is active, then set the timer, if not,
-		 * set the timer in remainder so that the timer will
-		 * be armed with the right value when the station will
-		 * wake up.
-		 */
-		if (!txq->frozen)
-			mod_timer(&txq->stuck_timer,
-				  jiffies + txq->wd_timeout);
-		else
-			txq->frozen_expiry_remainder = txq->wd_timeout;
-	}
+	/* start the stuck check if queue currently empty */
+	if (txq->read_ptr == txq->write_ptr)
+		iwl_txq_start_stuck_check(trans, txq);
 
 	/* Tell device the write index *just past* this latest filled TFD */
 	txq->write_ptr = iwl_txq_inc_wrap(trans, txq->write_ptr);
@@ -97,6 +97,10 @@ void iwl_txq_gen2_tfd_unmap(struct iwl_trans *trans, struct iwl_cmd_meta *meta,
 
 	/* first TB is never freed - it's the bidirectional DMA data */
 	for (i = 1; i < num_tbs; i++) {
+		/* header page TBs stay mapped for the lifetime of the queue */
+		if (meta->hdr_tbs & BIT(i))
+			continue;
+
 		if (meta->tbs & BIT(i))
 			dma_unmap_page(trans->dev,
 				       le64_to_cpu(tfd->tbs[i].addr),
@@ -109,6 +113,7 @@ void iwl_txq_gen2_tfd_unmap(struct iwl_trans *trans, struct iwl_cmd_meta *meta,
 					 DMA_TO_DEVICE);
 	}
 
+	meta->hdr_tbs = 0;
 	tfd->num_tbs = 0;
 }
 
@@ -195,6 +200,126 @@ static struct page *get_workaround_page(struct iwl_trans *trans,
 	return ret;
 }
 
+/*
+ * Header pages of gen2 data queues: A-MSDU subframe headers and the
+ * copies made for the TB hardware bug workaround are carved from a small
+ * ring of pages that are DMA mapped once, when first used, and then only
+ * synced for the device. TFDs are reclaimed in order, so a page can be
+ * reused as soon as the last TFD that points into it has been reclaimed;
+ * iwl_txq_gen2_reclaim_hdr_pages() does that once per completion batch
+ * instead of taking a page reference for every skb.
+ *
+ * Everything here is protected by the queue lock. When all pages are
+ * busy, the caller falls back to the per-CPU/per-skb pages.
+ */
+static u8 *iwl_txq_gen2_alloc_hdr(struct iwl_trans *trans,
+				  struct iwl_txq *txq, size_t len,
+				  dma_addr_t *dma)
+{
+	struct iwl_tso_hdr_page *p;
+	u8 *ret;
+	int i;
+
+	lockdep_assert_held(&txq->lock);
+
+	if (!txq->hdr_pages)
+		return NULL;
+
+	p = &txq->hdr_pages[txq->hdr_cur];
+
+	/*
+	 * As for the per-CPU pages, never hand out the last bytes of the
+	 * page so that no TB can end on a 32-bit boundary.
+	 */
+	if (p->page &&
+	    p->pos + len < (u8 *)page_address(p->page) + PAGE_SIZE -
+			   sizeof(void *))
+		goto out;
+
+	if (p->page) {
+		/* the current page is full, move on to the next idle one */
+		for (i = 1; i < IWL_TXQ_HDR_PAGES; i++) {
+			int idx = (txq->hdr_cur + i) % IWL_TXQ_HDR_PAGES;
+
+			if (txq->hdr_pages[idx].last_idx < 0) {
+				txq->hdr_cur = idx;
+				p = &txq->hdr_pages[idx];
+				break;
+			}
+		}
+		if (i == IWL_TXQ_HDR_PAGES)
+			return NULL;
+	}
+
+	if (!p->page) {
+		p->page = alloc_page(GFP_ATOMIC);
+		if (!p->page)
+			return NULL;
+		p->dma = dma_map_page(trans->dev, p->page, 0, PAGE_SIZE,
+				      DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(trans->dev, p->dma))) {
+			__free_page(p->page);
+			p->page = NULL;
+			return NULL;
+		}
+		p->pos = page_address(p->page);
+	}
+
+	if (p->pos + len >= (u8 *)page_address(p->page) + PAGE_SIZE -
+			    sizeof(void *))
+		return NULL;
+
+out:
+	ret = p->pos;
+	p->pos += len;
+	p->last_idx = txq->write_ptr;
+	*dma = p->dma + (ret - (u8 *)page_address(p->page));
+
+	return ret;
+}
+
+static void iwl_txq_gen2_reclaim_hdr_pages(struct iwl_txq *txq)
+{
+	int i;
+
+	lockdep_assert_held(&txq->lock);
+
+	if (!txq->hdr_pages)
+		return;
+
+	for (i = 0; i < IWL_TXQ_HDR_PAGES; i++) {
+		struct iwl_tso_hdr_page *p = &txq->hdr_pages[i];
+
+		if (p->last_idx < 0 || iwl_txq_used(txq, p->last_idx))
+			continue;
+
+		p->last_idx = -1;
+		p->pos = page_address(p->page);
+	}
+}
+
+static void iwl_txq_gen2_free_hdr_pages(struct iwl_trans *trans,
+					struct iwl_txq *txq)
+{
+	int i;
+
+	if (!txq->hdr_pages)
+		return;
+
+	for (i = 0; i < IWL_TXQ_HDR_PAGES; i++) {
+		struct iwl_tso_hdr_page *p = &txq->hdr_pages[i];
+
+		if (!p->page)
+			continue;
+
+		dma_unmap_page(trans->dev, p->dma, PAGE_SIZE, DMA_TO_DEVICE);
+		__free_page(p->page);
+	}
+
+	kfree(txq->hdr_pages);
+	txq->hdr_pages = NULL;
+}
+
 /*
  * Add a TB and if needed apply the FH HW bug workaround;
  * meta != NULL indicates that it's a page mapping and we
@@ -202,6 +327,7 @@ static struct page *get_workaround_page(struct iwl_trans *trans,
  * this case.
  */
 static int iwl_txq_gen2_set_tb_with_wa(struct iwl_trans *trans,
+				       struct iwl_txq *txq,
 				       struct sk_buff *skb,
 				       struct iwl_tfh_tfd *tfd,
 				       dma_addr_t phys, void *virt,
@@ -209,6 +335,7 @@ static int iwl_txq_gen2_set_tb_with_wa(struct iwl_trans *trans,
 {
 	dma_addr_t oldphys = phys;
 	struct page *page;
+	u8 *copy;
 	int ret;
 
 	if (unlikely(dma_mapping_error(trans->dev, phys)))
@@ -241,6 +368,22 @@ static int iwl_txq_gen2_set_tb_with_wa(struct iwl_trans *trans,
 		goto unmap;
 	}
 
+	copy = iwl_txq_gen2_alloc_hdr(trans, txq, len, &phys);
+	if (copy) {
+		struct iwl_cmd_meta *out_meta =
+			&txq->entries[iwl_txq_get_cmd_index(txq,
+							    txq->write_ptr)].meta;
+
+		memcpy(copy, virt, len);
+		dma_sync_single_for_device(trans->dev, phys, len,
+					   DMA_TO_DEVICE);
+		ret = iwl_txq_gen2_set_tb(trans, tfd, phys, len);
+		if (ret < 0)
+			goto unmap;
+		out_meta->hdr_tbs |= BIT(ret);
+		goto copied;
+	}
+
 	page = get_workaround_page(trans, skb);
 	if (!page) {
 		ret = -ENOMEM;
@@ -260,6 +403,7 @@ static int iwl_txq_gen2_set_tb_with_wa(struct iwl_trans *trans,
 		meta = NULL;
 		goto unmap;
 	}
+copied:
 	IWL_WARN(trans,
 		 "TB bug workaround: copied %d bytes from 0x%llx to 0x%llx\n",
 		 len, (unsigned long long)oldphys, (unsigned long long)phys);
@@ -323,9 +467,11 @@ out:
 #endif
 
 static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
+				    struct iwl_txq *txq,
 				    struct sk_buff *skb,
-				    struct iwl_tfh_tfd *tfd, int start_len,
-				    u8 hdr_len,
+				    struct iwl_tfh_tfd *tfd,
+				    struct iwl_cmd_meta *out_meta,
+				    int start_len, u8 hdr_len,
 				    struct iwl_device_tx_cmd *dev_cmd)
 {
 #ifdef CONFIG_INET
@@ -334,8 +480,9 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 	unsigned int snap_ip_tcp_hdrlen, ip_hdrlen, total_len, hdr_room;
 	unsigned int mss = skb_shinfo(skb)->gso_size;
 	u16 length, amsdu_pad;
-	u8 *start_hdr;
-	struct iwl_tso_hdr_page *hdr_page;
+	u8 *start_hdr, *hdr_base, *pos;
+	struct iwl_tso_hdr_page *hdr_page = NULL;
+	dma_addr_t hdr_dma = 0;
 	struct tso_t tso;
 
 	trace_iwlwifi_dev_tx(trans->dev, skb, tfd, sizeof(*tfd),
@@ -351,11 +498,16 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 		(3 + snap_ip_tcp_hdrlen + sizeof(struct ethhdr));
 
 	/* Our device supports 9 segments at most, it will fit in 1 page */
-	hdr_page = get_page_hdr(trans, hdr_room, skb);
-	if (!hdr_page)
-		return -ENOMEM;
+	hdr_base = iwl_txq_gen2_alloc_hdr(trans, txq, hdr_room, &hdr_dma);
+	if (!hdr_base) {
+		hdr_page = get_page_hdr(trans, hdr_room, skb);
+		if (!hdr_page)
+			return -ENOMEM;
+		hdr_base = hdr_page->pos;
+	}
 
-	start_hdr = hdr_page->pos;
+	pos = hdr_base;
+	start_hdr = pos;
 
 	/*
 	 * Pull the ieee80211 header to be able to use TSO core,
@@ -377,49 +529,59 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 		unsigned int data_left = min_t(unsigned int, mss, total_len);
 		unsigned int tb_len;
 		dma_addr_t tb_phys;
-		u8 *subf_hdrs_start = hdr_page->pos;
+		u8 *subf_hdrs_start = pos;
+		int tb_idx;
 
 		total_len -= data_left;
 
-		memset(hdr_page->pos, 0, amsdu_pad);
-		hdr_page->pos += amsdu_pad;
+		memset(pos, 0, amsdu_pad);
+		pos += amsdu_pad;
 		amsdu_pad = (4 - (sizeof(struct ethhdr) + snap_ip_tcp_hdrlen +
 				  data_left)) & 0x3;
-		ether_addr_copy(hdr_page->pos, ieee80211_get_DA(hdr));
-		hdr_page->pos += ETH_ALEN;
-		ether_addr_copy(hdr_page->pos, ieee80211_get_SA(hdr));
-		hdr_page->pos += ETH_ALEN;
+		ether_addr_copy(pos, ieee80211_get_DA(hdr));
+		pos += ETH_ALEN;
+		ether_addr_copy(pos, ieee80211_get_SA(hdr));
+		pos += ETH_ALEN;
 
 		length = snap_ip_tcp_hdrlen + data_left;
-		*((__be16 *)hdr_page->pos) = cpu_to_be16(length);
-		hdr_page->pos += sizeof(length);
+		*((__be16 *)pos) = cpu_to_be16(length);
+		pos += sizeof(length);
 
 		/*
 		 * This will copy the SNAP as well which will be considered
 		 * as MAC header.
 		 */
-		tso_build_hdr(skb, hdr_page->pos, &tso, data_left, !total_len);
-
-		hdr_page->pos += snap_ip_tcp_hdrlen;
-
-		tb_len = hdr_page->pos - start_hdr;
-		tb_phys = dma_map_single(trans->dev, start_hdr,
-					 tb_len, DMA_TO_DEVICE);
-		if (unlikely(dma_mapping_error(trans->dev, tb_phys)))
-			goto out_err;
+		tso_build_hdr(skb, pos, &tso, data_left, !total_len);
+
+		pos += snap_ip_tcp_hdrlen;
+
+		tb_len = pos - start_hdr;
+		if (!hdr_page) {
+			/* the queue's header page is already mapped */
+			tb_phys = hdr_dma + (start_hdr - hdr_base);
+			dma_sync_single_for_device(trans->dev, tb_phys,
+						   tb_len, DMA_TO_DEVICE);
+		} else {
+			tb_phys = dma_map_single(trans->dev, start_hdr,
+						 tb_len, DMA_TO_DEVICE);
+			if (unlikely(dma_mapping_error(trans->dev, tb_phys)))
+				goto out_err;
+		}
 		/*
 		 * No need for _with_wa, this is from the TSO page and
 		 * we leave some space at the end of it so can't hit
 		 * the buggy scenario.
 		 */
-		iwl_txq_gen2_set_tb(trans, tfd, tb_phys, tb_len);
+		tb_idx = iwl_txq_gen2_set_tb(trans, tfd, tb_phys, tb_len);
+		if (!hdr_page && tb_idx >= 0)
+			out_meta->hdr_tbs |= BIT(tb_idx);
 		trace_iwlwifi_dev_tx_tb(trans->dev, skb, start_hdr,
 					tb_phys, tb_len);
 		/* add this subframe's headers' length to the tx_cmd */
-		le16_add_cpu(&tx_cmd->len, hdr_page->pos - subf_hdrs_start);
+		le16_add_cpu(&tx_cmd->len, pos - subf_hdrs_start);
 
 		/* prepare the start_hdr for the next subframe */
-		start_hdr = hdr_page->pos;
+		start_hdr = pos;
 
 		/* put the payload */
 		while (data_left) {
@@ -428,7 +590,7 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 			tb_len = min_t(unsigned int, tso.size, data_left);
 			tb_phys = dma_map_single(trans->dev, tso.data,
 						 tb_len, DMA_TO_DEVICE);
-			ret = iwl_txq_gen2_set_tb_with_wa(trans, skb, tfd,
+			ret = iwl_txq_gen2_set_tb_with_wa(trans, txq, skb, tfd,
 							  tb_phys, tso.data,
 							  tb_len, NULL);
 			if (ret)
@@ -439,12 +601,17 @@ static int iwl_txq_gen2_build_amsdu(struct iwl_trans *trans,
 		}
 	}
 
+	if (hdr_page)
+		hdr_page->pos = pos;
+
 	/* re -add the WiFi header */
 	skb_push(skb, hdr_len);
 
 	return 0;
 
 out_err:
+	if (hdr_page)
+		hdr_page->pos = pos;
 #endif
 	return -EINVAL;
 }
@@ -495,8 +662,8 @@ iwl_tfh_tfd *iwl_txq_gen2_build_tx_amsdu(struct iwl_trans *trans,
 	 */
 	iwl_txq_gen2_set_tb(trans, tfd, tb_phys, len);
 
-	if (iwl_txq_gen2_build_amsdu(trans, skb, tfd, len + IWL_FIRST_TB_SIZE,
-				     hdr_len, dev_cmd))
+	if (iwl_txq_gen2_build_amsdu(trans, txq, skb, tfd, out_meta,
+				     len + IWL_FIRST_TB_SIZE, hdr_len, dev_cmd))
 		goto out_err;
 
 	/* building the A-MSDU might have changed this data, memcpy it now */
@@ -509,6 +676,7 @@ out_err:
 }
 
 static int iwl_txq_gen2_tx_add_frags(struct iwl_trans *trans,
+				     struct iwl_txq *txq,
 				     struct sk_buff *skb,
 				     struct iwl_tfh_tfd *tfd,
 				     struct iwl_cmd_meta *out_meta)
@@ -526,7 +694,7 @@ static int iwl_txq_gen2_tx_add_frags(struct iwl_trans *trans,
 
 		tb_phys = skb_frag_dma_map(trans->dev, frag, 0,
 					   fragsz, DMA_TO_DEVICE);
-		ret = iwl_txq_gen2_set_tb_with_wa(trans, skb, tfd, tb_phys,
+		ret = iwl_txq_gen2_set_tb_with_wa(trans, txq, skb, tfd, tb_phys,
 						  skb_frag_address(frag),
 						  fragsz, out_meta);
 		if (ret)
@@ -600,14 +768,14 @@ iwl_tfh_tfd *iwl_txq_gen2_build_tx(struct iwl_trans *trans,
 
 		tb_phys = dma_map_single(trans->dev, skb->data + hdr_len,
 					 tb2_len, DMA_TO_DEVICE);
-		ret = iwl_txq_gen2_set_tb_with_wa(trans, skb, tfd, tb_phys,
+		ret = iwl_txq_gen2_set_tb_with_wa(trans, txq, skb, tfd, tb_phys,
 						  skb->data + hdr_len, tb2_len,
 						  NULL);
 		if (ret)
 			goto out_err;
 	}
 
-	if (iwl_txq_gen2_tx_add_frags(trans, skb, tfd, out_meta))
+	if (iwl_txq_gen2_tx_add_frags(trans, txq, skb, tfd, out_meta))
 		goto out_err;
 
 	skb_walk_frags(skb, frag) {
@@ -615,12 +783,12 @@ iwl_tfh_tfd *iwl_txq_gen2_build_tx(struct iwl_trans *trans,
 
 		tb_phys = dma_map_single(trans->dev, frag->data,
 					 skb_headlen(frag), DMA_TO_DEVICE);
-		ret = iwl_txq_gen2_set_tb_with_wa(trans, skb, tfd, tb_phys,
+		ret = iwl_txq_gen2_set_tb_with_wa(trans, txq, skb, tfd, tb_phys,
 						  frag->data,
 						  skb_headlen(frag), NULL);
 		if (ret)
 			goto out_err;
-		if (iwl_txq_gen2_tx_add_frags(trans, frag, tfd, out_meta))
+		if (iwl_txq_gen2_tx_add_frags(trans, txq, frag, tfd, out_meta))
 			goto out_err;
 	}
 
@@ -747,6 +915,7 @@ int iwl_txq_gen2_tx(struct iwl_trans *trans, struct sk_buff *skb,
 	/* Set up driver data for this TFD */
 	txq->entries[idx].skb = skb;
 	txq->entries[idx].cmd = dev_cmd;
+	iwl_txq_tpt_tx(trans, txq, idx);
 
 	dev_cmd->hdr.sequence =
 		cpu_to_le16((u16)(QUEUE_TO_SEQ(txq_id) |
@@ -778,13 +947,21 @@ int iwl_txq_gen2_tx(struct iwl_trans *trans, struct sk_buff *skb,
 	iwl_pcie_gen2_update_byte_tbl(trans, txq, cmd_len,
 				      iwl_txq_gen2_get_num_tbs(trans, tfd));
 
-	/* start timer if queue currently empty */
-	if (txq->read_ptr == txq->write_ptr && txq->wd_timeout)
-		mod_timer(&txq->stuck_timer, jiffies + txq->wd_timeout);
+	/* start the stuck check if queue currently empty */
+	if (txq->read_ptr == txq->write_ptr)
+		iwl_txq_start_stuck_check(trans, txq);
 
 	/* Tell device the write index *just past* this latest filled TFD */
 	txq->write_ptr = iwl_txq_inc_wrap(trans, txq->write_ptr);
 	iwl_txq_inc_wr_ptr(trans, txq);
+
+	/*
+	 * Stop the queue once enough bytes are in flight, even if there
+	 * are still free TFDs, to keep the latency of the ring bounded.
+	 */
+	iwl_txq_bql_queued(txq, skb->len);
+	if (iwl_txq_bql_full(txq))
+		iwl_txq_stop(trans, txq);
 	/*
 	 * At this point the frame is "transmitted" successfully
 	 * and we will get a TX status notification eventually.
@@ -818,6 +995,10 @@ void iwl_txq_gen2_unmap(struct iwl_trans *trans, int txq_id)
 		txq->read_ptr = iwl_txq_inc_wrap(trans, txq->read_ptr);
 	}
 
+	iwl_txq_gen2_reclaim_hdr_pages(txq);
+	iwl_txq_bql_reset(txq);
+	txq->stuck_deadline = 0;
+
 	while (!skb_queue_empty(&txq->overflow_q)) {
 		struct sk_buff *skb = __skb_dequeue(&txq->overflow_q);
 
@@ -845,6 +1026,7 @@ static void iwl_txq_gen2_free_memory(struct iwl_trans *trans,
 				  txq->first_tb_bufs, txq->first_tb_dma);
 	}
 
+	iwl_txq_gen2_free_hdr_pages(trans, txq);
 	kfree(txq->entries);
 	if (txq->bc_tbl.addr)
 		dma_pool_free(trans->txqs.bc_pool,
@@ -882,11 +1064,12 @@ static void iwl_txq_gen2_free(struct iwl_trans *trans, int txq_id)
 			kfree_sensitive(txq->entries[i].cmd);
 			kfree_sensitive(txq->entries[i].free_buf);
 		}
-	del_timer_sync(&txq->stuck_timer);
-
-	iwl_txq_gen2_free_memory(trans, txq);
 
+	/* make sure the stuck check no longer looks at the queue */
 	trans->txqs.txq[txq_id] = NULL;
+	iwl_txq_stuck_sync(trans);
+
+	iwl_txq_gen2_free_memory(trans, txq);
 
 	clear_bit(txq_id, trans->txqs.queue_used);
 }
@@ -999,22 +1182,92 @@ void iwl_txq_log_scd_error(struct iwl_trans *trans, struct iwl_txq *txq)
 			iwl_read_direct32(trans, FH_TX_TRB_REG(fifo)));
 }
 
-static void iwl_txq_stuck_timer(struct timer_list *t)
+/*
+ * Stuck queue detection: rather than a timer per queue that is pushed
+ * forward on every reclaim, each queue only records the deadline by which
+ * it has to make progress. A single timer per device is armed for the
+ * earliest deadline and re-checks the queues when it fires, so under
+ * traffic it runs about once per watchdog period instead of being
+ * reprogrammed for every TX batch.
+ */
+static void iwl_txq_stuck_check_arm(struct iwl_trans *trans,
+				    unsigned long deadline)
 {
-	struct iwl_txq *txq = from_timer(txq, t, stuck_timer);
-	struct iwl_trans *trans = txq->trans;
+	/* queues arm it under their own locks, only ever pull it earlier */
+	timer_reduce(&trans->txqs.stuck_timer, deadline);
+}
 
-	spin_lock(&txq->lock);
-	/* check if triggered erroneously */
-	if (txq->read_ptr == txq->write_ptr) {
-		spin_unlock(&txq->lock);
+static unsigned long iwl_txq_deadline(unsigned long timeout)
+{
+	/* 0 means no deadline */
+	return (jiffies + timeout) ?: 1;
+}
+
+void iwl_txq_start_stuck_check(struct iwl_trans *trans, struct iwl_txq *txq)
+{
+	lockdep_assert_held(&txq->lock);
+
+	if (!txq->wd_timeout)
+		return;
+
+	/*
+	 * If the TXQ is frozen, arm the check with the full timeout once
+	 * the station wakes up.
+	 */
+	if (txq->frozen) {
+		txq->frozen_expiry_remainder = txq->wd_timeout;
 		return;
 	}
-	spin_unlock(&txq->lock);
 
-	iwl_txq_log_scd_error(trans, txq);
+	txq->stuck_deadline = iwl_txq_deadline(txq->wd_timeout);
+	iwl_txq_stuck_check_arm(trans, txq->stuck_deadline);
+}
+
+void iwl_txq_stuck_timer(struct timer_list *t)
+{
+	struct iwl_trans *trans = from_timer(trans, t, txqs.stuck_timer);
+	unsigned long now = jiffies, next = 0;
+	int i;
+
+	for (i = 0; i < IWL_MAX_TVQM_QUEUES; i++) {
+		struct iwl_txq *txq = trans->txqs.txq[i];
+		unsigned long deadline;
+
+		if (!txq)
+			continue;
+
+		spin_lock(&txq->lock);
+		/* the queue may have drained since the deadline was set */
+		if (txq->read_ptr == txq->write_ptr)
+			txq->stuck_deadline = 0;
+		deadline = txq->stuck_deadline;
+		spin_unlock(&txq->lock);
+
+		if (!deadline)
+			continue;
+
+		if (time_after_eq(now, deadline)) {
+			iwl_txq_log_scd_error(trans, txq);
+			iwl_force_nmi(trans);
+			return;
+		}
+
+		if (!next || time_before(deadline, next))
+			next = deadline;
+	}
+
+	if (next)
+		iwl_txq_stuck_check_arm(trans, next);
+}
 
-	iwl_force_nmi(trans);
+/*
+ * Wait for a running stuck check to finish, so a queue that was removed
+ * from the transport can be freed, then let the check resume.
+ */
+void iwl_txq_stuck_sync(struct iwl_trans *trans)
+{
+	if (del_timer_sync(&trans->txqs.stuck_timer))
+		mod_timer(&trans->txqs.stuck_timer, jiffies);
 }
 
 int iwl_txq_alloc(struct iwl_trans *trans, struct iwl_txq *txq, int slots_num,
@@ -1031,7 +1284,6 @@ int iwl_txq_alloc(struct iwl_trans *trans, struct iwl_txq *txq, int slots_num,
 	if (trans->trans_cfg->use_tfh)
 		tfd_sz = trans->txqs.tfd.size * slots_num;
 
-	timer_setup(&txq->stuck_timer, iwl_txq_stuck_timer, 0);
 	txq->trans = trans;
 
 	txq->n_window = slots_num;
@@ -1088,7 +1340,7 @@ static int iwl_txq_dyn_alloc_dma(struct iwl_trans *trans,
 {
 	size_t bc_tbl_size, bc_tbl_entries;
 	struct iwl_txq *txq;
-	int ret;
+	int ret, i;
 
 	WARN_ON(!trans->txqs.bc_tbl_size);
 
@@ -1121,7 +1373,17 @@ static int iwl_txq_dyn_alloc_dma(struct iwl_trans *trans,
 		goto error;
 	}
 
+	txq->hdr_pages = kcalloc(IWL_TXQ_HDR_PAGES, sizeof(*txq->hdr_pages),
+				 GFP_KERNEL);
+	if (!txq->hdr_pages) {
+		ret = -ENOMEM;
+		goto error;
+	}
+	for (i = 0; i < IWL_TXQ_HDR_PAGES; i++)
+		txq->hdr_pages[i].last_idx = -1;
+
 	txq->wd_timeout = msecs_to_jiffies(timeout);
+	iwl_txq_bql_init(txq);
 
 	*intxq = txq;
 	return 0;
@@ -1502,19 +1764,20 @@ void iwl_txq_progress(struct iwl_txq *txq)
 
 	/*
 	 * station is asleep and we send data - that must
-	 * be uAPSD or PS-Poll. Don't rearm the timer.
+	 * be uAPSD or PS-Poll. Don't move the deadline.
 	 */
 	if (txq->frozen)
 		return;
 
 	/*
-	 * if empty delete timer, otherwise move timer forward
-	 * since we're making progress on this queue
+	 * if empty drop the deadline, otherwise move it forward since
+	 * we're making progress on this queue; the device timer picks
+	 * the new deadline up when it fires
 	 */
 	if (txq->read_ptr == txq->write_ptr)
-		del_timer(&txq->stuck_timer);
+		txq->stuck_deadline = 0;
 	else
-		mod_timer(&txq->stuck_timer, jiffies + txq->wd_timeout);
+		txq->stuck_deadline = iwl_txq_deadline(txq->wd_timeout);
 }
 
 /* Frees buffers until index _not_ inclusive */
@@ -1524,6 +1787,8 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 	struct iwl_txq *txq = trans->txqs.txq[txq_id];
 	int tfd_num = iwl_txq_get_cmd_index(txq, ssn);
 	int read_ptr = iwl_txq_get_cmd_index(txq, txq->read_ptr);
+	unsigned int bytes = 0, frames = 0;
+	u64 now = ktime_get_ns();
 	int last_to_free;
 
 	/* This function is not meant to release cmd queue*/
@@ -1575,6 +1840,11 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 
 		iwl_txq_free_tso_page(trans, skb);
 
+		bytes += skb->len;
+		frames++;
+		iwl_trans_tpt_hist(trans, IWL_TPT_HIST_TX_LATENCY_US,
+				   div_u64(now - txq->entries[read_ptr].enq_ns,
+					   NSEC_PER_USEC));
 		__skb_queue_tail(skbs, skb);
 
 		txq->entries[read_ptr].skb = NULL;
@@ -1585,9 +1855,14 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 		iwl_txq_free_tfd(trans, txq);
 	}
 
+	iwl_txq_gen2_reclaim_hdr_pages(txq);
+	iwl_txq_bql_completed(txq, bytes);
+	iwl_trans_tpt_add(trans, IWL_TPT_TX_RECLAIMED, frames);
+
 	iwl_txq_progress(txq);
 
 	if (iwl_txq_space(trans, txq) > txq->low_mark &&
+	    !iwl_txq_bql_full(txq) &&
 	    test_bit(txq_id, trans->txqs.queue_stopped)) {
 		struct sk_buff_head overflow_skbs;
 
@@ -1627,7 +1902,8 @@ void iwl_txq_reclaim(struct iwl_trans *trans, int txq_id, int ssn,
 			iwl_trans_tx(trans, skb, dev_cmd_ptr, txq_id);
 		}
 
-		if (iwl_txq_space(trans, txq) > txq->low_mark)
+		if (iwl_txq_space(trans, txq) > txq->low_mark &&
+		    !iwl_txq_bql_full(txq))
 			iwl_wake_queue(trans, txq);
 
 		spin_lock_bh(&txq->lock);
@@ -1647,6 +1923,7 @@ void iwl_txq_set_q_ptrs(struct iwl_trans *trans, int txq_id, int ptr)
 
 	txq->write_ptr = ptr;
 	txq->read_ptr = txq->write_ptr;
+	iwl_txq_bql_reset(txq);
 
 	spin_unlock_bh(&txq->lock);
 }
@@ -1676,27 +1953,31 @@ void iwl_trans_txq_freeze_timer(struct iwl_trans *trans, unsigned long txqs,
 			goto next_queue;
 
 		if (freeze) {
-			if (unlikely(time_after(now,
-						txq->stuck_timer.expires))) {
+			if (unlikely(!txq->stuck_deadline ||
+				     time_after(now, txq->stuck_deadline))) {
 				/*
-				 * The timer should have fired, maybe it is
-				 * spinning right now on the lock.
+				 * The deadline already passed, leave it for
+				 * the stuck check that should be running.
 				 */
 				goto next_queue;
 			}
-			/* remember how long until the timer fires */
+			/* remember how long until the queue is stuck */
 			txq->frozen_expiry_remainder =
-				txq->stuck_timer.expires - now;
-			del_timer(&txq->stuck_timer);
+				txq->stuck_deadline - now;
+			txq->stuck_deadline = 0;
 			goto next_queue;
 		}
 
+		if (!txq->wd_timeout)
+			goto next_queue;
+
 		/*
-		 * Wake a non-empty queue -> arm timer with the
+		 * Wake a non-empty queue -> set the deadline with the
 		 * remainder before it froze
 		 */
-		mod_timer(&txq->stuck_timer,
-			  now + txq->frozen_expiry_remainder);
+		txq->stuck_deadline =
+			iwl_txq_deadline(txq->frozen_expiry_remainder);
+		iwl_txq_stuck_check_arm(trans, txq->stuck_deadline);
 
 next_queue:
 		spin_unlock_bh(&txq->lock);
@@ -7,11 +7,21 @@
 #include "iwl-fh.h"
 #include "fw/api/tx.h"
 
+/*
+ * Header page that TSO/A-MSDU subframe headers are carved from. The
+ * per-CPU pages of the legacy path only use @page and @pos; the pages
+ * of a gen2 queue's header ring are mapped once at @dma and stay busy
+ * until the TFD at @last_idx has been reclaimed (-1 when idle).
+ */
 struct iwl_tso_hdr_page {
 	struct page *page;
 	u8 *pos;
+	dma_addr_t dma;
+	int last_idx;
 };
 
+#define IWL_TXQ_HDR_PAGES	16
+
 static inline dma_addr_t
 iwl_txq_get_first_tb_dma(struct iwl_txq *txq, int idx)
 {
@@ -62,6 +72,7 @@ static inline void iwl_txq_stop(struct iwl_trans *trans, struct iwl_txq *txq)
 {
 	if (!test_and_set_bit(txq->id, trans->txqs.queue_stopped)) {
 		iwl_op_mode_queue_full(trans->op_mode, txq->id);
+		iwl_trans_tpt_inc(trans, IWL_TPT_TX_STOPS);
 		IWL_DEBUG_TX_QUEUES(trans, "Stop hwq %d\n", txq->id);
 	} else {
 		IWL_DEBUG_TX_QUEUES(trans, "hwq %d already stopped\n",
@@ -69,6 +80,18 @@ static inline void iwl_txq_stop(struct iwl_trans *trans, struct iwl_txq *txq)
 	}
 }
 
+/* account for a data frame that is put on the ring at @idx */
+static inline void iwl_txq_tpt_tx(struct iwl_trans *trans,
+				  struct iwl_txq *txq, int idx)
+{
+	u32 used = (txq->write_ptr - txq->read_ptr) &
+		   (trans->trans_cfg->base_params->max_tfd_queue_size - 1);
+
+	txq->entries[idx].enq_ns = ktime_get_ns();
+	iwl_trans_tpt_inc(trans, IWL_TPT_TX_FRAMES);
+	iwl_trans_tpt_hist(trans, IWL_TPT_HIST_TFD_USED, used);
+}
+
 /**
  * iwl_txq_inc_wrap - increment queue index, wrap back to beginning
  * @index -- current index
@@ -102,6 +125,56 @@ static inline bool iwl_txq_used(const struct iwl_txq *q, int i)
 
 void iwl_txq_free_tso_page(struct iwl_trans *trans, struct sk_buff *skb);
 
+#ifdef CONFIG_BQL
+static inline void iwl_txq_bql_init(struct iwl_txq *txq)
+{
+	dql_init(&txq->dql, HZ);
+	txq->bql = true;
+}
+
+static inline void iwl_txq_bql_reset(struct iwl_txq *txq)
+{
+	if (txq->bql)
+		dql_reset(&txq->dql);
+}
+
+static inline void iwl_txq_bql_queued(struct iwl_txq *txq, unsigned int bytes)
+{
+	if (txq->bql)
+		dql_queued(&txq->dql, bytes);
+}
+
+static inline void iwl_txq_bql_completed(struct iwl_txq *txq,
+					 unsigned int bytes)
+{
+	unsigned int inflight;
+
+	if (!txq->bql || !bytes)
+		return;
+
+	inflight = txq->dql.num_queued - txq->dql.num_completed;
+	if (WARN_ON_ONCE(bytes > inflight))
+		bytes = inflight;
+	dql_completed(&txq->dql, bytes);
+}
+
+static inline bool iwl_txq_bql_full(struct iwl_txq *txq)
+{
+	return txq->bql && dql_avail(&txq->dql) < 0;
+}
+#else
+static inline void iwl_txq_bql_init(struct iwl_txq *txq) {}
+static inline void iwl_txq_bql_reset(struct iwl_txq *txq) {}
+static inline void iwl_txq_bql_queued(struct iwl_txq *txq,
+				      unsigned int bytes) {}
+static inline void iwl_txq_bql_completed(struct iwl_txq *txq,
+					 unsigned int bytes) {}
+static inline bool iwl_txq_bql_full(struct iwl_txq *txq)
+{
+	return false;
+}
+#endif
+
 void iwl_txq_log_scd_error(struct iwl_trans *trans, struct iwl_txq *txq);
 
 int iwl_txq_gen2_set_tb(struct iwl_trans *trans,
@@ -179,6 +252,9 @@ void iwl_txq_set_q_ptrs(struct iwl_trans *trans, int txq_id, int ptr);
 void iwl_trans_txq_freeze_timer(struct iwl_trans *trans, unsigned long txqs,
 				bool freeze);
 void iwl_txq_progress(struct iwl_txq *txq);
+void iwl_txq_stuck_timer(struct timer_list *t);
+void iwl_txq_start_stuck_check(struct iwl_trans *trans, struct iwl_txq *txq);
+void iwl_txq_stuck_sync(struct iwl_trans *trans);
 void iwl_txq_free_tfd(struct iwl_trans *trans, struct iwl_txq *txq);
 int iwl_trans_txq_send_hcmd(struct iwl_trans *trans, struct iwl_host_cmd *cmd);
 #endif /* __iwl_trans_queue_tx_h__ */
@@ -12,6 +12,7 @@
 
 
 #include <linux/kernel.h>
+#include <linux/debugfs.h>
 #include <linux/dmi.h>
 #include <linux/firmware.h>
 #include <linux/gpio/consumer.h>
@@ -21,9 +22,12 @@
 #include <linux/input/touchscreen.h>
 #include <linux/module.h>
 #include <linux/delay.h>
+#include <linux/hrtimer.h>
 #include <linux/irq.h>
 #include <linux/interrupt.h>
 #include <linux/regulator/consumer.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/acpi.h>
 #include <linux/of.h>
@@ -58,6 +62,12 @@
 #define GOODIX_BUFFER_STATUS_READY	BIT(7)
 #define GOODIX_HAVE_KEY			BIT(4)
 #define GOODIX_BUFFER_STATUS_TIMEOUT	20
+#define GOODIX_READY_DELAY_MAX_US	10000
+
+#define GOODIX_POLLS_HIST_SIZE		8
+#define GOODIX_LATENCY_HIST_SIZE	16
+#define GOODIX_XFERS_HIST_SIZE		4
+#define GOODIX_TOUCH_HINT_DECAY		16
 
 #define RESOLUTION_LOC		1
 #define MAX_CONTACTS_LOC	5
@@ -91,6 +101,21 @@ struct goodix_chip_id {
 
 #define GOODIX_ID_MAX_LEN	4
 
+struct goodix_report_stats {
+	u64 reports;
+	u64 reads;
+	u64 early_giveups;
+	u64 timeouts;
+	/* Reports that needed 1, 2, ..., >= GOODIX_POLLS_HIST_SIZE reads */
+	u64 polls_hist[GOODIX_POLLS_HIST_SIZE];
+	/* IRQ to ready, log2 buckets in us: < 1, < 2, < 4, ... */
+	u64 latency_hist[GOODIX_LATENCY_HIST_SIZE];
+	u64 xfers;
+	u64 short_prefetch;
+	/* Interrupts that needed 1, 2, ..., >= GOODIX_XFERS_HIST_SIZE transfers */
+	u64 xfers_hist[GOODIX_XFERS_HIST_SIZE];
+};
+
 struct goodix_ts_data {
 	struct i2c_client *client;
 	struct input_dev *input_dev;
@@ -115,6 +140,16 @@ struct goodix_ts_data {
 	unsigned int contact_size;
 	u8 config[GOODIX_CONFIG_MAX_LENGTH];
 	unsigned short keymap[GOODIX_MAX_KEYS];
+	ktime_t irq_time;
+	unsigned int ready_delay_us;
+	bool last_released;
+	unsigned int touch_hint;
+	unsigned int touch_hint_low;
+	bool batch_end_cmd;
+	bool end_cmd_sent;
+	int irq_xfers;
+	struct goodix_report_stats stats;
+	struct dentry *debugfs;
 };
 
 static int goodix_check_cfg_8(struct goodix_ts_data *ts,
@@ -337,6 +372,46 @@ static int goodix_i2c_write_u8(struct i2c_client *client, u16 reg, u8 value)
 	return goodix_i2c_write(client, reg, &value, sizeof(value));
 }
 
+/**
+ * goodix_i2c_read_end - read coordinate data and write the end command
+ *
+ * @client: i2c device.
+ * @reg: the register to read from.
+ * @buf: buffer for the coordinate data.
+ * @len: number of bytes to read.
+ *
+ * Reads the last part of a report whose buffer status is known to be ready
+ * and clears GOODIX_READ_COOR_ADDR in the same transfer, saving the separate
+ * end command write.
+ */
+static int goodix_i2c_read_end(struct i2c_client *client, u16 reg, u8 *buf,
+			       int len)
+{
+	struct i2c_msg msgs[3];
+	__be16 wbuf = cpu_to_be16(reg);
+	u8 end_cmd[3] = { GOODIX_READ_COOR_ADDR >> 8,
+			  GOODIX_READ_COOR_ADDR & 0xff, 0 };
+	int ret;
+
+	msgs[0].flags = 0;
+	msgs[0].addr  = client->addr;
+	msgs[0].len   = 2;
+	msgs[0].buf   = (u8 *)&wbuf;
+
+	msgs[1].flags = I2C_M_RD;
+	msgs[1].addr  = client->addr;
+	msgs[1].len   = len;
+	msgs[1].buf   = buf;
+
+	msgs[2].flags = 0;
+	msgs[2].addr  = client->addr;
+	msgs[2].len   = sizeof(end_cmd);
+	msgs[2].buf   = end_cmd;
+
+	ret = i2c_transfer(client->adapter, msgs, 3);
+	return ret < 0 ? ret : (ret != ARRAY_SIZE(msgs) ? -EIO : 0);
+}
+
 static const struct goodix_chip_data *goodix_get_chip_data(const char *id)
 {
 	unsigned int i;
@@ -349,60 +424,160 @@ static const struct goodix_chip_data *goodix_get_chip_data(const char *id)
 	return &gt9x_chip_data;
 }
 
+/**
+ * goodix_ts_ready - account a report whose buffer status was ready
+ *
+ * @ts: our goodix_ts_data pointer
+ * @polls: number of header reads it took
+ *
+ * Updates the statistics and the learned IRQ-to-ready delay. If the first
+ * read was already ready we may be sleeping longer than needed, so the delay
+ * shrinks slowly. If we had to poll, it moves towards the observed delay.
+ */
+static void goodix_ts_ready(struct goodix_ts_data *ts, int polls)
+{
+	struct goodix_report_stats *stats = &ts->stats;
+	s64 elapsed = ktime_us_delta(ktime_get(), ts->irq_time);
+
+	stats->reports++;
+	stats->polls_hist[min(polls, GOODIX_POLLS_HIST_SIZE) - 1]++;
+	if (elapsed >= 0)
+		stats->latency_hist[min_t(int, fls64(elapsed),
+					  GOODIX_LATENCY_HIST_SIZE - 1)]++;
+
+	if (polls == 1)
+		ts->ready_delay_us -= ts->ready_delay_us / 16;
+	else if (elapsed > ts->ready_delay_us)
+		ts->ready_delay_us += (elapsed - ts->ready_delay_us) / 4;
+
+	ts->ready_delay_us = min(ts->ready_delay_us,
+				 (unsigned int)GOODIX_READY_DELAY_MAX_US);
+}
+
+/*
+ * The number of contacts prefetched with the header follows the largest
+ * recent touch count, and drops by one after GOODIX_TOUCH_HINT_DECAY reports
+ * with fewer contacts.
+ */
+static void goodix_ts_update_touch_hint(struct goodix_ts_data *ts,
+					int touch_num)
+{
+	if (touch_num > ts->touch_hint) {
+		ts->touch_hint = min(touch_num, GOODIX_MAX_CONTACTS);
+		ts->touch_hint_low = 0;
+	} else if (touch_num == ts->touch_hint) {
+		ts->touch_hint_low = 0;
+	} else if (++ts->touch_hint_low >= GOODIX_TOUCH_HINT_DECAY) {
+		ts->touch_hint = max(ts->touch_hint - 1, 1U);
+		ts->touch_hint_low = 0;
+	}
+}
+
 static int goodix_ts_read_input_report(struct goodix_ts_data *ts, u8 *data)
 {
 	unsigned long max_timeout;
+	ktime_t ready_at;
 	int touch_num;
+	int polls = 0;
 	int error;
-	u16 addr = GOODIX_READ_COOR_ADDR;
+	int size;
+	int len;
 	/*
 	 * We are going to read 1-byte header,
 	 * ts->contact_size * max(1, touch_num) bytes of coordinates
 	 * and 1-byte footer which contains the touch-key code.
+	 * The first read prefetches as many contacts as recent reports had.
 	 */
 	const int header_contact_keycode_size = 1 + ts->contact_size + 1;
+	const int prefetch_size = 1 + ts->contact_size * ts->touch_hint + 1;
 
 	/*
 	 * The 'buffer status' bit, which indicates that the data is valid, is
 	 * not set as soon as the interrupt is raised, but slightly after.
-	 * This takes around 10 ms to happen, so we poll for 20 ms.
+	 * This takes up to around 10 ms, but is fairly constant for a given
+	 * controller. Sleep until the learned delay has passed and read once,
+	 * falling back to polling for up to 20 ms.
 	 */
+	ready_at = ktime_add_us(ts->irq_time, ts->ready_delay_us);
+	if (ktime_before(ktime_get(), ready_at)) {
+		set_current_state(TASK_UNINTERRUPTIBLE);
+		schedule_hrtimeout_range(&ready_at, 100 * NSEC_PER_USEC,
+					 HRTIMER_MODE_ABS);
+	}
+
 	max_timeout = jiffies + msecs_to_jiffies(GOODIX_BUFFER_STATUS_TIMEOUT);
 	do {
-		error = goodix_i2c_read(ts->client, addr, data,
-					header_contact_keycode_size);
+		size = polls ? header_contact_keycode_size : prefetch_size;
+		error = goodix_i2c_read(ts->client, GOODIX_READ_COOR_ADDR,
+					data, size);
+		ts->irq_xfers++;
 		if (error) {
 			dev_err(&ts->client->dev, "I2C transfer error: %d\n",
 					error);
 			return error;
 		}
 
+		polls++;
+		ts->stats.reads++;
+
 		if (data[0] & GOODIX_BUFFER_STATUS_READY) {
+			goodix_ts_ready(ts, polls);
+
 			touch_num = data[0] & 0x0f;
 			if (touch_num > ts->max_touch_num)
 				return -EPROTO;
 
-			if (touch_num > 1) {
-				addr += header_contact_keycode_size;
-				data += header_contact_keycode_size;
-				error = goodix_i2c_read(ts->client,
-						addr, data,
-						ts->contact_size *
-							(touch_num - 1));
+			ts->last_released = touch_num == 0;
+			goodix_ts_update_touch_hint(ts, touch_num);
+
+			/*
+			 * If the prefetch did not cover all contacts, read the
+			 * rest. The buffer is known to be ready here, so the end
+			 * command can follow in the same transfer. Otherwise it
+			 * is written by the IRQ handler after the last read.
+			 */
+			len = 1 + ts->contact_size * touch_num + 1;
+			if (len > size) {
+				ts->stats.short_prefetch++;
+				if (ts->batch_end_cmd)
+					error = goodix_i2c_read_end(ts->client,
+						GOODIX_READ_COOR_ADDR + size,
+						data + size, len - size);
+				else
+					error = goodix_i2c_read(ts->client,
+						GOODIX_READ_COOR_ADDR + size,
+						data + size, len - size);
+				ts->irq_xfers++;
 				if (error)
 					return error;
+
+				ts->end_cmd_sent = ts->batch_end_cmd;
 			}
 
 			return touch_num;
 		}
 
+		/*
+		 * The Goodix panel will send a spurious interrupt after a
+		 * 'finger up' event, whose buffer never becomes ready. Give it
+		 * one more read instead of polling until the timeout, unless
+		 * the first read already shows activity, which means this is
+		 * a real touch that is just not ready yet.
+		 */
+		if (polls == 1 && data[0])
+			ts->last_released = false;
+
+		if (ts->last_released && polls >= 2) {
+			ts->last_released = false;
+			ts->stats.early_giveups++;
+			return -ENOMSG;
+		}
+
 		usleep_range(1000, 2000); /* Poll every 1 - 2 ms */
 	} while (time_before(jiffies, max_timeout));
 
-	/*
-	 * The Goodix panel will send spurious interrupts after a
-	 * 'finger up' event, which will always cause a timeout.
-	 */
+	ts->last_released = false;
+	ts->stats.timeouts++;
 	return -ENOMSG;
 }
 
@@ -487,6 +662,23 @@ static void goodix_process_events(struct goodix_ts_data *ts)
 	input_sync(ts->input_dev);
 }
 
+/**
+ * goodix_ts_irq_primary - The hard IRQ handler
+ *
+ * @irq: interrupt number.
+ * @dev_id: private data pointer.
+ *
+ * Records when the interrupt was raised, so the threaded handler knows
+ * when the report should be ready.
+ */
+static irqreturn_t goodix_ts_irq_primary(int irq, void *dev_id)
+{
+	struct goodix_ts_data *ts = dev_id;
+
+	ts->irq_time = ktime_get();
+	return IRQ_WAKE_THREAD;
+}
+
 /**
  * goodix_ts_irq_handler - The IRQ handler
  *
@@ -496,11 +688,21 @@ static void goodix_process_events(struct goodix_ts_data *ts)
 static irqreturn_t goodix_ts_irq_handler(int irq, void *dev_id)
 {
 	struct goodix_ts_data *ts = dev_id;
+	struct goodix_report_stats *stats = &ts->stats;
+
+	ts->end_cmd_sent = false;
+	ts->irq_xfers = 0;
 
 	goodix_process_events(ts);
 
-	if (goodix_i2c_write_u8(ts->client, GOODIX_READ_COOR_ADDR, 0) < 0)
-		dev_err(&ts->client->dev, "I2C write end_cmd error\n");
+	if (!ts->end_cmd_sent) {
+		if (goodix_i2c_write_u8(ts->client, GOODIX_READ_COOR_ADDR, 0) < 0)
+			dev_err(&ts->client->dev, "I2C write end_cmd error\n");
+		ts->irq_xfers++;
+	}
+
+	stats->xfers += ts->irq_xfers;
+	stats->xfers_hist[min(ts->irq_xfers, GOODIX_XFERS_HIST_SIZE) - 1]++;
 
 	return IRQ_HANDLED;
 }
@@ -513,7 +715,8 @@ static void goodix_free_irq(struct goodix_ts_data *ts)
 static int goodix_request_irq(struct goodix_ts_data *ts)
 {
 	return devm_request_threaded_irq(&ts->client->dev, ts->client->irq,
-					 NULL, goodix_ts_irq_handler,
+					 goodix_ts_irq_primary,
+					 goodix_ts_irq_handler,
 					 ts->irq_flags, ts->client->name, ts);
 }
 
@@ -1222,6 +1425,67 @@ static void goodix_disable_regulators(void *arg)
 	regulator_disable(ts->avdd28);
 }
 
+static int goodix_debugfs_reports_show(struct seq_file *s, void *unused)
+{
+	struct goodix_ts_data *ts = s->private;
+	struct goodix_report_stats *stats = &ts->stats;
+	int i;
+
+	seq_printf(s, "reports: %llu\n", stats->reports);
+	seq_printf(s, "reads: %llu\n", stats->reads);
+	seq_printf(s, "early give-ups: %llu\n", stats->early_giveups);
+	seq_printf(s, "timeouts: %llu\n", stats->timeouts);
+	seq_printf(s, "ready delay: %u us\n", ts->ready_delay_us);
+	seq_printf(s, "i2c transfers: %llu\n", stats->xfers);
+	seq_printf(s, "short prefetch: %llu\n", stats->short_prefetch);
+	seq_printf(s, "touch hint: %u\n", ts->touch_hint);
+	seq_printf(s, "end command batched: %s\n",
+		   ts->batch_end_cmd ? "yes" : "no");
+
+	seq_puts(s, "i2c transfers per interrupt:\n");
+	for (i = 0; i < GOODIX_XFERS_HIST_SIZE; i++)
+		seq_printf(s, "  %s%d: %llu\n",
+			   i == GOODIX_XFERS_HIST_SIZE - 1 ? ">=" : "",
+			   i + 1, stats->xfers_hist[i]);
+
+	seq_puts(s, "reads per report:\n");
+	for (i = 0; i < GOODIX_POLLS_HIST_SIZE; i++)
+		seq_printf(s, "  %s%d: %llu\n",
+			   i == GOODIX_POLLS_HIST_SIZE - 1 ? ">=" : "",
+			   i + 1, stats->polls_hist[i]);
+
+	seq_puts(s, "irq to ready:\n");
+	for (i = 0; i < GOODIX_LATENCY_HIST_SIZE; i++)
+		seq_printf(s, "  %s%u us: %llu\n",
+			   i == GOODIX_LATENCY_HIST_SIZE - 1 ? ">=" : "<",
+			   i == GOODIX_LATENCY_HIST_SIZE - 1 ?
+				1U << (i - 1) : 1U << i,
+			   stats->latency_hist[i]);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(goodix_debugfs_reports);
+
+static struct dentry *goodix_debugfs_root;
+
+static void goodix_debugfs_remove(void *arg)
+{
+	struct goodix_ts_data *ts = arg;
+
+	debugfs_remove_recursive(ts->debugfs);
+}
+
+static int goodix_debugfs_init(struct goodix_ts_data *ts)
+{
+	ts->debugfs = debugfs_create_dir(dev_name(&ts->client->dev),
+					 goodix_debugfs_root);
+	debugfs_create_file("reports", 0444, ts->debugfs, ts,
+			    &goodix_debugfs_reports_fops);
+
+	return devm_add_action_or_reset(&ts->client->dev,
+					goodix_debugfs_remove, ts);
+}
+
 static int goodix_ts_probe(struct i2c_client *client,
 			   const struct i2c_device_id *id)
 {
@@ -1243,6 +1507,9 @@ static int goodix_ts_probe(struct i2c_client *client,
 	i2c_set_clientdata(client, ts);
 	init_completion(&ts->firmware_loading_complete);
 	ts->contact_size = GOODIX_CONTACT_SIZE;
+	ts->touch_hint = 1;
+	/* Adapters with quirks may not handle a read followed by a write */
+	ts->batch_end_cmd = !client->adapter->quirks;
 
 #ifdef CONFIG_ACPI
 	struct dmi_system_id *dmi_match = dmi_first_match(need_gpio_mapping);
@@ -1284,6 +1551,10 @@ static int goodix_ts_probe(struct i2c_client *client,
 	if (error)
 		return error;
 
+	error = goodix_debugfs_init(ts);
+	if (error)
+		return error;
+
 reset:
 	if (ts->reset_controller_at_probe) {
 		/* reset the controller */
@@ -1498,7 +1769,27 @@ static struct i2c_driver goodix_ts_driver = {
 		.pm = &goodix_pm_ops,
 	},
 };
-module_i2c_driver(goodix_ts_driver);
+
+static int __init goodix_ts_init(void)
+{
+	int error;
+
+	goodix_debugfs_root = debugfs_create_dir("goodix_ts", NULL);
+
+	error = i2c_add_driver(&goodix_ts_driver);
+	if (error)
+		debugfs_remove_recursive(goodix_debugfs_root);
+
+	return error;
+}
+module_init(goodix_ts_init);
+
+static void __exit goodix_ts_exit(void)
+{
+	i2c_del_driver(&goodix_ts_driver);
+	debugfs_remove_recursive(goodix_debugfs_root);
+}
+module_exit(goodix_ts_exit);
 
 MODULE_AUTHOR("Benjamin Tissoires <benjamin.tissoires@gmail.com>");
 MODULE_AUTHOR("Bastien Nocera <hadess@hadess.net>");
@@ -10,9 +10,13 @@
 #define _IPTS_CONTEXT_H_
 
 #include <linux/cdev.h>
+#include <linux/debugfs.h>
 #include <linux/device.h>
+#include <linux/ktime.h>
 #include <linux/mei_cl_bus.h>
+#include <linux/mutex.h>
 #include <linux/types.h>
+#include <linux/workqueue.h>
 
 #include "protocol.h"
 
@@ -28,6 +32,39 @@ struct ipts_buffer_info {
 	dma_addr_t dma_address;
 };
 
+/*
+ * The ME only accepts one outstanding command of each type, so feedback for
+ * completed buffers is queued and sent once the previous one was answered.
+ */
+struct ipts_feedback_queue {
+	struct mutex lock;
+
+	u32 pending;
+	int inflight;
+	int last;
+	ktime_t sent;
+	struct delayed_work timeout;
+
+	u64 queued;
+	u64 merged;
+	u64 sends;
+	u64 responses;
+	u64 timeouts;
+	u32 depth_max;
+	u64 rtt_total_ns;
+	u64 rtt_max_ns;
+};
+
+struct ipts_start_stats {
+	ktime_t begin;
+
+	u64 starts;
+	u64 allocs;
+	u64 reuses;
+	s64 last_us;
+	s64 max_us;
+};
+
 struct ipts_context {
 	struct mei_cl_device *cldev;
 	struct device *dev;
@@ -38,10 +75,19 @@ struct ipts_context {
 
 	struct ipts_buffer_info data[IPTS_BUFFERS];
 	struct ipts_buffer_info doorbell;
+	struct task_struct *doorbell_thread;
 
 	struct ipts_buffer_info feedback[IPTS_BUFFERS];
 	struct ipts_buffer_info workqueue;
 	struct ipts_buffer_info host2me;
+
+	/* Sizes the buffers above were allocated with */
+	u32 data_buffer_size;
+	u32 feedback_buffer_size;
+
+	struct ipts_start_stats start_stats;
+	struct ipts_feedback_queue feedback_queue;
+	struct dentry *debugfs;
 };
 
 #endif /* _IPTS_CONTEXT_H_ */
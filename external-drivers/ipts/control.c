@@ -6,13 +6,24 @@
  * Linux driver for Intel Precise Touch & Stylus
  */
 
+#include <linux/bitops.h>
+#include <linux/ktime.h>
 #include <linux/mei_cl_bus.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "context.h"
 #include "protocol.h"
+#include "receiver.h"
 #include "resources.h"
 #include "uapi.h"
 
+/*
+ * If the ME did not answer the outstanding feedback command after this time,
+ * it is given up on and the next queued one is sent.
+ */
+#define IPTS_FEEDBACK_TIMEOUT_MS 50
+
 int ipts_control_send(struct ipts_context *ipts, u32 code, void *payload,
 		      size_t size)
 {
@@ -43,6 +54,142 @@ int ipts_control_send_feedback(struct ipts_context *ipts, u32 buffer)
 	return ipts_control_send(ipts, IPTS_CMD_FEEDBACK, &cmd, sizeof(cmd));
 }
 
+static void ipts_control_feedback_reset(struct ipts_context *ipts)
+{
+	struct ipts_feedback_queue *queue = &ipts->feedback_queue;
+
+	mutex_lock(&queue->lock);
+	queue->pending = 0;
+	queue->inflight = -1;
+	queue->last = IPTS_BUFFERS - 1;
+	cancel_delayed_work(&queue->timeout);
+	mutex_unlock(&queue->lock);
+}
+
+/* Must be called with the queue lock held */
+static int ipts_control_feedback_next(struct ipts_context *ipts)
+{
+	u32 buffer;
+	struct ipts_feedback_queue *queue = &ipts->feedback_queue;
+
+	if (!queue->pending || queue->inflight >= 0)
+		return 0;
+
+	/* Return buffers in the order the ME filled them */
+	buffer = (queue->last + 1) % IPTS_BUFFERS;
+	while (!(queue->pending & BIT(buffer)))
+		buffer = (buffer + 1) % IPTS_BUFFERS;
+
+	queue->pending &= ~BIT(buffer);
+	queue->inflight = buffer;
+	queue->last = buffer;
+	queue->sent = ktime_get();
+	queue->sends++;
+
+	schedule_delayed_work(&queue->timeout,
+			      msecs_to_jiffies(IPTS_FEEDBACK_TIMEOUT_MS));
+
+	return ipts_control_send_feedback(ipts, buffer);
+}
+
+static void ipts_control_feedback_timeout(struct work_struct *work)
+{
+	int ret;
+	struct ipts_feedback_queue *queue = container_of(
+		to_delayed_work(work), struct ipts_feedback_queue, timeout);
+	struct ipts_context *ipts =
+		container_of(queue, struct ipts_context, feedback_queue);
+
+	mutex_lock(&queue->lock);
+
+	/*
+	 * The response may have arrived and the next command may have been
+	 * sent while this was waiting for the lock.
+	 */
+	if (queue->inflight < 0 || ipts->status != IPTS_HOST_STATUS_STARTED ||
+	    ktime_ms_delta(ktime_get(), queue->sent) <
+		    IPTS_FEEDBACK_TIMEOUT_MS) {
+		mutex_unlock(&queue->lock);
+		return;
+	}
+
+	queue->timeouts++;
+	queue->inflight = -1;
+
+	ret = ipts_control_feedback_next(ipts);
+
+	mutex_unlock(&queue->lock);
+
+	if (ret)
+		dev_err(ipts->dev, "Failed to resend feedback: %d\n", ret);
+}
+
+void ipts_control_feedback_init(struct ipts_context *ipts)
+{
+	struct ipts_feedback_queue *queue = &ipts->feedback_queue;
+
+	mutex_init(&queue->lock);
+	INIT_DELAYED_WORK(&queue->timeout, ipts_control_feedback_timeout);
+}
+
+void ipts_control_feedback_free(struct ipts_context *ipts)
+{
+	cancel_delayed_work_sync(&ipts->feedback_queue.timeout);
+}
+
+int ipts_control_queue_feedback(struct ipts_context *ipts, u32 buffer)
+{
+	int ret;
+	u32 depth;
+	struct ipts_feedback_queue *queue = &ipts->feedback_queue;
+
+	if (buffer >= IPTS_BUFFERS)
+		return -EINVAL;
+
+	mutex_lock(&queue->lock);
+
+	if (queue->pending & BIT(buffer))
+		queue->merged++;
+
+	queue->pending |= BIT(buffer);
+	queue->queued++;
+
+	depth = hweight32(queue->pending);
+	if (depth > queue->depth_max)
+		queue->depth_max = depth;
+
+	ret = ipts_control_feedback_next(ipts);
+
+	mutex_unlock(&queue->lock);
+	return ret;
+}
+
+int ipts_control_feedback_done(struct ipts_context *ipts, u32 buffer)
+{
+	int ret;
+	u64 rtt;
+	struct ipts_feedback_queue *queue = &ipts->feedback_queue;
+
+	mutex_lock(&queue->lock);
+
+	if (queue->inflight >= 0 && buffer == queue->inflight) {
+		rtt = ktime_to_ns(ktime_sub(ktime_get(), queue->sent));
+
+		queue->responses++;
+		queue->rtt_total_ns += rtt;
+		if (rtt > queue->rtt_max_ns)
+			queue->rtt_max_ns = rtt;
+
+		queue->inflight = -1;
+		cancel_delayed_work(&queue->timeout);
+	}
+
+	ret = ipts_control_feedback_next(ipts);
+
+	mutex_unlock(&queue->lock);
+	return ret;
+}
+
 int ipts_control_set_feature(struct ipts_context *ipts, u8 report, u8 value)
 {
 	struct ipts_feedback_buffer *feedback;
@@ -68,6 +215,9 @@ int ipts_control_start(struct ipts_context *ipts)
 	dev_info(ipts->dev, "Starting IPTS\n");
 	ipts->status = IPTS_HOST_STATUS_STARTING;
 	ipts->restart = false;
+	ipts->start_stats.begin = ktime_get();
+
+	ipts_control_feedback_reset(ipts);
 
 	ipts_uapi_link(ipts);
 	return ipts_control_send(ipts, IPTS_CMD_GET_DEVICE_INFO, NULL, 0);
@@ -84,8 +234,11 @@ int ipts_control_stop(struct ipts_context *ipts)
 	dev_info(ipts->dev, "Stopping IPTS\n");
 	ipts->status = IPTS_HOST_STATUS_STOPPING;
 
+	/* The stop sequence sends feedback for all buffers itself */
+	ipts_control_feedback_reset(ipts);
+
 	ipts_uapi_unlink();
-	ipts_resources_free(ipts);
+	ipts_receiver_doorbell_stop(ipts);
 
 	return ipts_control_send_feedback(ipts, 0);
 }
@@ -16,6 +16,10 @@
 int ipts_control_send(struct ipts_context *ipts, u32 cmd, void *payload,
 		      size_t size);
 int ipts_control_send_feedback(struct ipts_context *ipts, u32 buffer);
+int ipts_control_queue_feedback(struct ipts_context *ipts, u32 buffer);
+int ipts_control_feedback_done(struct ipts_context *ipts, u32 buffer);
+void ipts_control_feedback_init(struct ipts_context *ipts);
+void ipts_control_feedback_free(struct ipts_context *ipts);
 int ipts_control_set_feature(struct ipts_context *ipts, u8 report, u8 value);
 int ipts_control_start(struct ipts_context *ipts);
 int ipts_control_restart(struct ipts_context *ipts);
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Copyright (c) 2016 Intel Corporation
+ * Copyright (c) 2020 Dorian Stoll
+ *
+ * Linux driver for Intel Precise Touch & Stylus
+ */
+
+#include <linux/bitops.h>
+#include <linux/debugfs.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+
+#include "context.h"
+#include "debugfs.h"
+
+static int ipts_debugfs_feedback_show(struct seq_file *s, void *unused)
+{
+	u64 rtt_avg = 0;
+	struct ipts_context *ipts = s->private;
+	struct ipts_feedback_queue *queue = &ipts->feedback_queue;
+
+	mutex_lock(&queue->lock);
+
+	if (queue->responses)
+		rtt_avg = div64_u64(queue->rtt_total_ns, queue->responses);
+
+	seq_printf(s, "queued:        %llu\n", queue->queued);
+	seq_printf(s, "merged:        %llu\n", queue->merged);
+	seq_printf(s, "sent:          %llu\n", queue->sends);
+	seq_printf(s, "responses:     %llu\n", queue->responses);
+	seq_printf(s, "timeouts:      %llu\n", queue->timeouts);
+	seq_printf(s, "depth:         %u\n", hweight32(queue->pending));
+	seq_printf(s, "depth max:     %u\n", queue->depth_max);
+	seq_printf(s, "rtt avg (ns):  %llu\n", rtt_avg);
+	seq_printf(s, "rtt max (ns):  %llu\n", queue->rtt_max_ns);
+
+	mutex_unlock(&queue->lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(ipts_debugfs_feedback);
+
+static int ipts_debugfs_start_show(struct seq_file *s, void *unused)
+{
+	struct ipts_context *ipts = s->private;
+	struct ipts_start_stats *stats = &ipts->start_stats;
+
+	seq_printf(s, "starts:        %llu\n", stats->starts);
+	seq_printf(s, "allocations:   %llu\n", stats->allocs);
+	seq_printf(s, "reuses:        %llu\n", stats->reuses);
+	seq_printf(s, "last (us):     %lld\n", stats->last_us);
+	seq_printf(s, "max (us):      %lld\n", stats->max_us);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(ipts_debugfs_start);
+
+void ipts_debugfs_init(struct ipts_context *ipts)
+{
+	ipts->debugfs = debugfs_create_dir("ipts", NULL);
+	debugfs_create_file("feedback", 0444, ipts->debugfs, ipts,
+			    &ipts_debugfs_feedback_fops);
+	debugfs_create_file("start", 0444, ipts->debugfs, ipts,
+			    &ipts_debugfs_start_fops);
+}
+
+void ipts_debugfs_free(struct ipts_context *ipts)
+{
+	debugfs_remove_recursive(ipts->debugfs);
+	ipts->debugfs = NULL;
+}
@@ -0,0 +1,17 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (c) 2016 Intel Corporation
+ * Copyright (c) 2020 Dorian Stoll
+ *
+ * Linux driver for Intel Precise Touch & Stylus
+ */
+
+#ifndef _IPTS_DEBUGFS_H_
+#define _IPTS_DEBUGFS_H_
+
+#include "context.h"
+
+void ipts_debugfs_init(struct ipts_context *ipts);
+void ipts_debugfs_free(struct ipts_context *ipts);
+
+#endif /* _IPTS_DEBUGFS_H_ */
@@ -16,9 +16,11 @@
 
 #include "context.h"
 #include "control.h"
+#include "debugfs.h"
 #include "linux/device.h"
 #include "protocol.h"
 #include "receiver.h"
+#include "resources.h"
 #include "uapi.h"
 
 static int ipts_mei_set_dma_mask(struct mei_cl_device *cldev)
@@ -58,11 +60,20 @@ static int ipts_mei_probe(struct mei_cl_device *cldev,
 	ipts->cldev = cldev;
 	ipts->dev = &cldev->dev;
 	ipts->status = IPTS_HOST_STATUS_STOPPED;
+	ipts_control_feedback_init(ipts);
+
+	ipts_debugfs_init(ipts);
 
 	mei_cldev_set_drvdata(cldev, ipts);
 	mei_cldev_register_rx_cb(cldev, ipts_receiver_callback);
 
-	return ipts_control_start(ipts);
+	ret = ipts_control_start(ipts);
+	if (ret) {
+		ipts_control_feedback_free(ipts);
+		ipts_debugfs_free(ipts);
+	}
+
+	return ret;
 }
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 11, 0))
 static int ipts_mei_remove(struct mei_cl_device *cldev)
@@ -84,7 +95,10 @@ static int ipts_mei_remove(struct mei_cl_device *cldev)
 		msleep(25);
 	}
 
+	ipts_control_feedback_free(ipts);
+	ipts_debugfs_free(ipts);
 	mei_cldev_disable(cldev);
+	ipts_resources_free(ipts);
 	
 	return 0;
 }
@@ -108,7 +122,10 @@ static void ipts_mei_remove(struct mei_cl_device *cldev)
 		msleep(25);
 	}
 
+	ipts_control_feedback_free(ipts);
+	ipts_debugfs_free(ipts);
 	mei_cldev_disable(cldev);
+	ipts_resources_free(ipts);
 }
 #endif
 
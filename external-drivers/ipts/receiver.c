@@ -6,6 +6,9 @@
  * Linux driver for Intel Precise Touch & Stylus
  */
 
+#include <linux/delay.h>
+#include <linux/jiffies.h>
+#include <linux/kthread.h>
 #include <linux/mei_cl_bus.h>
 #include <linux/moduleparam.h>
 #include <linux/types.h>
@@ -13,7 +16,19 @@
 #include "context.h"
 #include "control.h"
 #include "protocol.h"
+#include "receiver.h"
 #include "resources.h"
+#include "uapi.h"
+
+/*
+ * The ME does not notify the host when it rings the doorbell, it only
+ * increments the value in the doorbell buffer. While data is flowing the
+ * buffer is checked every IPTS_DOORBELL_ACTIVE_US, after one second without
+ * new data the interval drops to IPTS_DOORBELL_IDLE_MS. The thread is parked
+ * by the UAPI while no device file is open.
+ */
+#define IPTS_DOORBELL_ACTIVE_US 2000
+#define IPTS_DOORBELL_IDLE_MS	20
 
 /*
  * Temporary parameter to guard gen7 multitouch mode.
@@ -78,14 +93,83 @@ static int ipts_receiver_handle_set_mode(struct ipts_context *ipts)
 				 sizeof(cmd));
 }
 
+static int ipts_receiver_doorbell_loop(void *data)
+{
+	u32 doorbell;
+	u32 last = 0;
+	unsigned long active = jiffies;
+	struct ipts_context *ipts = data;
+
+	while (!kthread_should_stop()) {
+		if (kthread_should_park()) {
+			kthread_parkme();
+			continue;
+		}
+
+		doorbell = READ_ONCE(*(u32 *)ipts->doorbell.address);
+
+		if (doorbell != last) {
+			last = doorbell;
+			active = jiffies + HZ;
+			ipts_uapi_doorbell(doorbell);
+		}
+
+		if (time_before(jiffies, active))
+			usleep_range(IPTS_DOORBELL_ACTIVE_US,
+				     IPTS_DOORBELL_ACTIVE_US + 500);
+		else
+			msleep_interruptible(IPTS_DOORBELL_IDLE_MS);
+	}
+
+	return 0;
+}
+
+int ipts_receiver_doorbell_start(struct ipts_context *ipts)
+{
+	struct task_struct *thread;
+
+	thread = kthread_create(ipts_receiver_doorbell_loop, ipts,
+				"ipts_doorbell");
+	if (IS_ERR(thread))
+		return PTR_ERR(thread);
+
+	ipts->doorbell_thread = thread;
+	ipts_uapi_doorbell_attach(thread);
+
+	return 0;
+}
+
+void ipts_receiver_doorbell_stop(struct ipts_context *ipts)
+{
+	if (!ipts->doorbell_thread)
+		return;
+
+	ipts_uapi_doorbell_detach();
+	kthread_stop(ipts->doorbell_thread);
+	ipts->doorbell_thread = NULL;
+}
+
 static int ipts_receiver_handle_set_mem_window(struct ipts_context *ipts)
 {
 	int ret;
-
-	dev_info(ipts->dev, "Device %04hX:%04hX ready\n",
-		 ipts->device_info.vendor_id, ipts->device_info.device_id);
+	s64 elapsed;
+	struct ipts_start_stats *stats = &ipts->start_stats;
+
+	elapsed = ktime_us_delta(ktime_get(), stats->begin);
+	stats->starts++;
+	stats->last_us = elapsed;
+	if (elapsed > stats->max_us)
+		stats->max_us = elapsed;
+
+	dev_info(ipts->dev, "Device %04hX:%04hX ready (%lld ms)\n",
+		 ipts->device_info.vendor_id, ipts->device_info.device_id,
+		 elapsed / USEC_PER_MSEC);
 	ipts->status = IPTS_HOST_STATUS_STARTED;
 
+	ret = ipts_receiver_doorbell_start(ipts);
+	if (ret)
+		return ret;
+
 	ret = ipts_control_send(ipts, IPTS_CMD_READY_FOR_DATA, NULL, 0);
 	if (ret)
 		return ret;
@@ -101,11 +185,14 @@ static int ipts_receiver_handle_feedback(struct ipts_context *ipts,
 {
 	struct ipts_feedback_rsp feedback;
 
+	memcpy(&feedback, rsp->payload, sizeof(feedback));
+
+	if (ipts->status == IPTS_HOST_STATUS_STARTED)
+		return ipts_control_feedback_done(ipts, feedback.buffer);
+
 	if (ipts->status != IPTS_HOST_STATUS_STOPPING)
 		return 0;
 
-	memcpy(&feedback, rsp->payload, sizeof(feedback));
-
 	if (feedback.buffer < IPTS_BUFFERS - 1)
 		return ipts_control_send_feedback(ipts, feedback.buffer + 1);
 
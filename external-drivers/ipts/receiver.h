@@ -11,6 +11,10 @@
 
 #include <linux/mei_cl_bus.h>
 
+#include "context.h"
+
 void ipts_receiver_callback(struct mei_cl_device *cldev);
+int ipts_receiver_doorbell_start(struct ipts_context *ipts);
+void ipts_receiver_doorbell_stop(struct ipts_context *ipts);
 
 #endif /* _IPTS_RECEIVER_H_ */
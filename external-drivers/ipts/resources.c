@@ -15,8 +15,8 @@ void ipts_resources_free(struct ipts_context *ipts)
 	int i;
 	struct ipts_buffer_info *buffers;
 
-	u32 data_buffer_size = ipts->device_info.data_size;
-	u32 feedback_buffer_size = ipts->device_info.feedback_size;
+	u32 data_buffer_size = ipts->data_buffer_size;
+	u32 feedback_buffer_size = ipts->feedback_buffer_size;
 
 	buffers = ipts->data;
 	for (i = 0; i < IPTS_BUFFERS; i++) {
@@ -68,6 +68,34 @@ void ipts_resources_free(struct ipts_context *ipts)
 		ipts->host2me.address = NULL;
 		ipts->host2me.dma_address = 0;
 	}
+
+	ipts->data_buffer_size = 0;
+	ipts->feedback_buffer_size = 0;
+}
+
+/*
+ * Buffers are kept across restarts and sensor resets. If the sizes reported
+ * by the device did not change, only the state shared with the ME is cleared.
+ */
+static bool ipts_resources_reuse(struct ipts_context *ipts)
+{
+	int i;
+
+	if (!ipts->host2me.address)
+		return false;
+
+	if (ipts->data_buffer_size != ipts->device_info.data_size ||
+	    ipts->feedback_buffer_size != ipts->device_info.feedback_size)
+		return false;
+
+	for (i = 0; i < IPTS_BUFFERS; i++)
+		memset(ipts->feedback[i].address, 0, ipts->feedback_buffer_size);
+
+	memset(ipts->doorbell.address, 0, sizeof(u32));
+	memset(ipts->workqueue.address, 0, sizeof(u32));
+	memset(ipts->host2me.address, 0, ipts->feedback_buffer_size);
+
+	return true;
 }
 
 int ipts_resources_alloc(struct ipts_context *ipts)
@@ -78,6 +106,17 @@ int ipts_resources_alloc(struct ipts_context *ipts)
 	u32 data_buffer_size = ipts->device_info.data_size;
 	u32 feedback_buffer_size = ipts->device_info.feedback_size;
 
+	if (ipts_resources_reuse(ipts)) {
+		ipts->start_stats.reuses++;
+		return 0;
+	}
+
+	ipts_resources_free(ipts);
+
+	ipts->data_buffer_size = data_buffer_size;
+	ipts->feedback_buffer_size = feedback_buffer_size;
+	ipts->start_stats.allocs++;
+
 	buffers = ipts->data;
 	for (i = 0; i < IPTS_BUFFERS; i++) {
 		buffers[i].address =
@@ -116,7 +155,7 @@ int ipts_resources_alloc(struct ipts_context *ipts)
 		dma_alloc_coherent(ipts->dev, feedback_buffer_size,
 				   &ipts->host2me.dma_address, GFP_KERNEL);
 
-	if (!ipts->workqueue.address)
+	if (!ipts->host2me.address)
 		goto release_resources;
 
 	return 0;
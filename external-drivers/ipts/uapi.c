@@ -9,9 +9,15 @@
 #include <linux/cdev.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#include <linux/dma-mapping.h>
 #include <linux/fs.h>
+#include <linux/kthread.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/uaccess.h>
+#include <linux/version.h>
 
 #include "context.h"
 #include "control.h"
@@ -20,6 +26,53 @@
 
 struct ipts_uapi uapi;
 
+struct ipts_uapi_file {
+	struct list_head list;
+	struct file *file;
+
+	/* The doorbell value this file has last been told about */
+	u32 doorbell;
+};
+
+static int ipts_uapi_open(struct inode *inode, struct file *file)
+{
+	struct ipts_uapi_file *ufile;
+
+	ufile = kzalloc(sizeof(*ufile), GFP_KERNEL);
+	if (!ufile)
+		return -ENOMEM;
+
+	ufile->file = file;
+	file->private_data = ufile;
+
+	mutex_lock(&uapi.lock);
+
+	/* Someone may wait for the doorbell now, start watching it */
+	if (list_empty(&uapi.files) && uapi.doorbell_thread)
+		kthread_unpark(uapi.doorbell_thread);
+
+	list_add(&ufile->list, &uapi.files);
+	mutex_unlock(&uapi.lock);
+
+	return 0;
+}
+
+static int ipts_uapi_release(struct inode *inode, struct file *file)
+{
+	struct ipts_uapi_file *ufile = file->private_data;
+
+	mutex_lock(&uapi.lock);
+	list_del(&ufile->list);
+
+	if (list_empty(&uapi.files) && uapi.doorbell_thread)
+		kthread_park(uapi.doorbell_thread);
+
+	mutex_unlock(&uapi.lock);
+
+	kfree(ufile);
+	return 0;
+}
+
 static ssize_t ipts_uapi_read(struct file *file, char __user *buf, size_t count,
 			      loff_t *offset)
 {
@@ -42,6 +95,70 @@ static ssize_t ipts_uapi_read(struct file *file, char __user *buf, size_t count,
 	return count;
 }
 
+/*
+ * The data buffers are mapped read-only. When IPTS is stopped,
+ * ipts_uapi_unlink() zaps all mappings, so userspace has to map the buffers
+ * again once the device is ready.
+ */
+static int ipts_uapi_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	int ret;
+	int buffer;
+	size_t size = vma->vm_end - vma->vm_start;
+	struct ipts_context *ipts;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(6, 3, 0))
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+#else
+	vm_flags_mod(vma, VM_DONTEXPAND | VM_DONTDUMP, VM_MAYWRITE);
+#endif
+
+	buffer = MINOR(file->f_path.dentry->d_inode->i_rdev);
+
+	mutex_lock(&uapi.lock);
+	ipts = uapi.ipts;
+
+	if (!ipts || ipts->status != IPTS_HOST_STATUS_STARTED) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	if (vma->vm_pgoff >= PAGE_ALIGN(ipts->data_buffer_size) >> PAGE_SHIFT ||
+	    size > PAGE_ALIGN(ipts->data_buffer_size) -
+			   (vma->vm_pgoff << PAGE_SHIFT)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ret = dma_mmap_coherent(ipts->dev, vma, ipts->data[buffer].address,
+				ipts->data[buffer].dma_address,
+				ipts->data_buffer_size);
+
+out:
+	mutex_unlock(&uapi.lock);
+	return ret;
+}
+
+static __poll_t ipts_uapi_poll(struct file *file, poll_table *wait)
+{
+	struct ipts_uapi_file *ufile = file->private_data;
+	struct ipts_context *ipts = uapi.ipts;
+
+	poll_wait(file, &uapi.doorbell_wait, wait);
+
+	if (!ipts || ipts->status != IPTS_HOST_STATUS_STARTED)
+		return EPOLLERR;
+
+	if (READ_ONCE(uapi.doorbell) != ufile->doorbell)
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
 static long ipts_uapi_ioctl_get_device_ready(struct ipts_context *ipts,
 					     unsigned long arg)
 {
@@ -79,19 +196,68 @@ static long ipts_uapi_ioctl_get_device_info(struct ipts_context *ipts,
 }
 
 static long ipts_uapi_ioctl_get_doorbell(struct ipts_context *ipts,
-					 unsigned long arg)
+					 struct file *file, unsigned long arg)
 {
+	struct ipts_uapi_file *ufile = file->private_data;
 	void __user *buffer = (void __user *)arg;
 
 	if (!ipts || ipts->status != IPTS_HOST_STATUS_STARTED)
 		return -ENODEV;
 
+	ufile->doorbell = READ_ONCE(uapi.doorbell);
+
 	if (copy_to_user(buffer, ipts->doorbell.address, sizeof(u32)))
 		return -EFAULT;
 
 	return 0;
 }
 
+static bool ipts_uapi_doorbell_changed(struct ipts_context *ipts, u32 doorbell)
+{
+	return uapi.ipts != ipts || ipts->status != IPTS_HOST_STATUS_STARTED ||
+	       READ_ONCE(uapi.doorbell) != doorbell;
+}
+
+static long ipts_uapi_ioctl_wait_doorbell(struct ipts_context *ipts,
+					  struct file *file, unsigned long arg)
+{
+	long ret;
+	long timeout;
+	struct ipts_doorbell_wait wait;
+	struct ipts_uapi_file *ufile = file->private_data;
+	void __user *buffer = (void __user *)arg;
+
+	if (!ipts || ipts->status != IPTS_HOST_STATUS_STARTED)
+		return -ENODEV;
+
+	if (copy_from_user(&wait, buffer, sizeof(wait)))
+		return -EFAULT;
+
+	timeout = MAX_SCHEDULE_TIMEOUT;
+	if (wait.timeout)
+		timeout = msecs_to_jiffies(wait.timeout);
+
+	ret = wait_event_interruptible_timeout(uapi.doorbell_wait,
+			ipts_uapi_doorbell_changed(ipts, wait.doorbell),
+			timeout);
+	if (ret < 0)
+		return ret;
+
+	if (uapi.ipts != ipts || ipts->status != IPTS_HOST_STATUS_STARTED)
+		return -ENODEV;
+
+	if (ret == 0)
+		return -ETIMEDOUT;
+
+	wait.doorbell = READ_ONCE(uapi.doorbell);
+	ufile->doorbell = wait.doorbell;
+
+	if (copy_to_user(buffer, &wait, sizeof(wait)))
+		return -EFAULT;
+
+	return 0;
+}
+
 static long ipts_uapi_ioctl_send_feedback(struct ipts_context *ipts,
 					  struct file *file)
 {
@@ -103,7 +269,7 @@ static long ipts_uapi_ioctl_send_feedback(struct ipts_context *ipts,
 
 	buffer = MINOR(file->f_path.dentry->d_inode->i_rdev);
 
-	ret = ipts_control_send_feedback(ipts, buffer);
+	ret = ipts_control_queue_feedback(ipts, buffer);
 	if (ret)
 		return -EFAULT;
 
@@ -139,11 +305,13 @@ static long ipts_uapi_ioctl(struct file *file, unsigned int cmd,
 	case IPTS_IOCTL_GET_DEVICE_INFO:
 		return ipts_uapi_ioctl_get_device_info(ipts, arg);
 	case IPTS_IOCTL_GET_DOORBELL:
-		return ipts_uapi_ioctl_get_doorbell(ipts, arg);
+		return ipts_uapi_ioctl_get_doorbell(ipts, file, arg);
 	case IPTS_IOCTL_SEND_FEEDBACK:
 		return ipts_uapi_ioctl_send_feedback(ipts, file);
 	case IPTS_IOCTL_SEND_RESET:
 		return ipts_uapi_ioctl_send_reset(ipts);
+	case IPTS_IOCTL_WAIT_DOORBELL:
+		return ipts_uapi_ioctl_wait_doorbell(ipts, file, arg);
 	default:
 		return -ENOTTY;
 	}
@@ -151,7 +319,11 @@ static long ipts_uapi_ioctl(struct file *file, unsigned int cmd,
 
 static const struct file_operations ipts_uapi_fops = {
 	.owner = THIS_MODULE,
+	.open = ipts_uapi_open,
+	.release = ipts_uapi_release,
 	.read = ipts_uapi_read,
+	.mmap = ipts_uapi_mmap,
+	.poll = ipts_uapi_poll,
 	.unlocked_ioctl = ipts_uapi_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = ipts_uapi_ioctl,
@@ -160,18 +332,66 @@ static const struct file_operations ipts_uapi_fops = {
 
 void ipts_uapi_link(struct ipts_context *ipts)
 {
+	mutex_lock(&uapi.lock);
 	uapi.ipts = ipts;
+	uapi.doorbell = 0;
+	mutex_unlock(&uapi.lock);
 }
 
 void ipts_uapi_unlink(void)
 {
+	struct ipts_uapi_file *ufile;
+
+	mutex_lock(&uapi.lock);
 	uapi.ipts = NULL;
+
+	/* The data buffers are about to be freed */
+	list_for_each_entry(ufile, &uapi.files, list)
+		unmap_mapping_range(ufile->file->f_mapping, 0, 0, 1);
+
+	mutex_unlock(&uapi.lock);
+
+	wake_up_interruptible_all(&uapi.doorbell_wait);
+}
+
+void ipts_uapi_doorbell(u32 doorbell)
+{
+	WRITE_ONCE(uapi.doorbell, doorbell);
+	wake_up_interruptible_all(&uapi.doorbell_wait);
+}
+
+/*
+ * The doorbell thread is created by the receiver once the device is ready.
+ * It is parked right away if no file is open.
+ */
+void ipts_uapi_doorbell_attach(struct task_struct *thread)
+{
+	mutex_lock(&uapi.lock);
+	uapi.doorbell_thread = thread;
+
+	if (list_empty(&uapi.files))
+		kthread_park(thread);
+	else
+		wake_up_process(thread);
+
+	mutex_unlock(&uapi.lock);
+}
+
+void ipts_uapi_doorbell_detach(void)
+{
+	mutex_lock(&uapi.lock);
+	uapi.doorbell_thread = NULL;
+	mutex_unlock(&uapi.lock);
 }
 
 int ipts_uapi_init(void)
 {
 	int i, major;
 
+	mutex_init(&uapi.lock);
+	INIT_LIST_HEAD(&uapi.files);
+	init_waitqueue_head(&uapi.doorbell_wait);
+
 	alloc_chrdev_region(&uapi.dev, 0, IPTS_BUFFERS, "ipts");
 	uapi.class = class_create(THIS_MODULE, "ipts");
 
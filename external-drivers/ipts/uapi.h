@@ -9,7 +9,11 @@
 #ifndef _IPTS_UAPI_H_
 #define _IPTS_UAPI_H_
 
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
 #include <linux/types.h>
+#include <linux/wait.h>
 
 #include "context.h"
 
@@ -19,6 +23,16 @@ struct ipts_uapi {
 	struct cdev cdev;
 
 	struct ipts_context *ipts;
+
+	/* Protects ipts against mmap, and the file list */
+	struct mutex lock;
+	struct list_head files;
+
+	u32 doorbell;
+	wait_queue_head_t doorbell_wait;
+
+	/* Only runs while a file is open, protected by lock */
+	struct task_struct *doorbell_thread;
 };
 
 struct ipts_device_info {
@@ -32,14 +46,28 @@ struct ipts_device_info {
 	__u8 reserved[19];
 };
 
+/*
+ * In: the last doorbell value the caller has seen, and the maximum time to
+ * wait for it to change in ms (0 waits forever).
+ * Out: the new doorbell value.
+ */
+struct ipts_doorbell_wait {
+	__u32 doorbell;
+	__u32 timeout;
+};
+
 #define IPTS_IOCTL_GET_DEVICE_READY _IOR(0x86, 0x01, __u8)
 #define IPTS_IOCTL_GET_DEVICE_INFO  _IOR(0x86, 0x02, struct ipts_device_info)
 #define IPTS_IOCTL_GET_DOORBELL	    _IOR(0x86, 0x03, __u32)
 #define IPTS_IOCTL_SEND_FEEDBACK    _IO(0x86, 0x04)
 #define IPTS_IOCTL_SEND_RESET	    _IO(0x86, 0x05)
+#define IPTS_IOCTL_WAIT_DOORBELL    _IOWR(0x86, 0x06, struct ipts_doorbell_wait)
 
 void ipts_uapi_link(struct ipts_context *ipts);
 void ipts_uapi_unlink(void);
+void ipts_uapi_doorbell(u32 doorbell);
+void ipts_uapi_doorbell_attach(struct task_struct *thread);
+void ipts_uapi_doorbell_detach(void);
 
 int ipts_uapi_init(void);
 void ipts_uapi_free(void);
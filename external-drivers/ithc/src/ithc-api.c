@@ -6,14 +6,29 @@
 // Reading from the chardev will obtain one or more messages containing data, or block if there is no new data.
 // Only complete messages can be read; if the provided user buffer is too small, read() will return -EMSGSIZE instead of performing a partial read.
 // Each message has a header (struct ithc_api_header) containing a sequential message number and the size of the data.
+//
+// Alternatively the chardev can be mapped read-only to consume messages without copies. The first page holds a struct ithc_api_ring,
+// followed by the NUM_RX_ALLOC receive buffers. Message m is in slot m % num_slots while tail <= m < head. After reading a message,
+// check that tail is still <= m, otherwise the buffer was handed back to the device and the data may be corrupt.
+// poll() on a mapped file reports POLLIN when head changed since the last time it did so.
+
+struct ithc_api_file {
+	struct ithc_api *api;
+	bool mapped;
+	u32 poll_head;
+};
+
+static struct ithc_api *ithc_api_from_file(struct file *f) {
+	return ((struct ithc_api_file *)f->private_data)->api;
+}
 
 static loff_t ithc_api_llseek(struct file *f, loff_t offset, int whence) {
-	struct ithc_api *a = container_of(f->private_data, struct ithc_api, m);
+	struct ithc_api *a = ithc_api_from_file(f);
 	return generic_file_llseek_size(f, offset, whence, MAX_LFS_FILESIZE, READ_ONCE(a->rx->pos));
 }
 
 static ssize_t ithc_api_read_unlocked(struct file *f, char __user *buf, size_t size, loff_t *offset) {
-	struct ithc_api *a = container_of(f->private_data, struct ithc_api, m);
+	struct ithc_api *a = ithc_api_from_file(f);
 	loff_t pos = READ_ONCE(a->rx->pos);
 	unsigned n = a->rx->num_received;
 	unsigned newest = (n + NUM_RX_ALLOC - 1) % NUM_RX_ALLOC;
@@ -51,7 +66,7 @@ static ssize_t ithc_api_read_unlocked(struct file *f, char __user *buf, size_t s
 	return nread;
 }
 static ssize_t ithc_api_read(struct file *f, char __user *buf, size_t size, loff_t *offset) {
-	struct ithc_api *a = container_of(f->private_data, struct ithc_api, m);
+	struct ithc_api *a = ithc_api_from_file(f);
 	if (f->f_pos >= READ_ONCE(a->rx->pos)) {
 		if (f->f_flags & O_NONBLOCK) return -EWOULDBLOCK;
 		if (wait_event_interruptible(a->rx->wait, f->f_pos < READ_ONCE(a->rx->pos))) return -ERESTARTSYS;
@@ -64,25 +79,67 @@ static ssize_t ithc_api_read(struct file *f, char __user *buf, size_t size, loff
 }
 
 static __poll_t ithc_api_poll(struct file *f, struct poll_table_struct *pt) {
-	struct ithc_api *a = container_of(f->private_data, struct ithc_api, m);
+	struct ithc_api_file *af = f->private_data;
+	struct ithc_api *a = af->api;
 	poll_wait(f, &a->rx->wait, pt);
+	if (READ_ONCE(af->mapped)) {
+		u32 head = READ_ONCE(a->rx->ring->head);
+		if (head == af->poll_head) return 0;
+		af->poll_head = head;
+		return POLLIN;
+	}
 	if (f->f_pos < READ_ONCE(a->rx->pos)) return POLLIN;
 	return 0;
 }
 
+static int ithc_api_mmap(struct file *f, struct vm_area_struct *vma) {
+	struct ithc_api_file *af = f->private_data;
+	struct ithc_dma_rx *rx = af->api->rx;
+	unsigned long addr = vma->vm_start;
+	if (vma->vm_flags & VM_WRITE) return -EPERM;
+	if (vma->vm_pgoff || vma_pages(vma) > 1 + NUM_RX_ALLOC * rx->prds.num_pages) return -EINVAL;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+	// the ring page and the data buffer pages are all individually allocated order 0 pages
+	int r = vm_insert_page(vma, addr, virt_to_page(rx->ring));
+	if (r) return r;
+	addr += PAGE_SIZE;
+	for (unsigned i = 0; i < NUM_RX_ALLOC && addr < vma->vm_end; i++) {
+		struct scatterlist *sg;
+		int j;
+		for_each_sgtable_sg(rx->bufs[i].sgt, sg, j) {
+			if (addr >= vma->vm_end) break;
+			r = vm_insert_page(vma, addr, sg_page(sg));
+			if (r) return r;
+			addr += PAGE_SIZE;
+		}
+	}
+	af->poll_head = READ_ONCE(rx->ring->head);
+	WRITE_ONCE(af->mapped, true);
+	return 0;
+}
+
 static int ithc_api_open(struct inode *n, struct file *f) {
 	struct ithc_api *a = container_of(f->private_data, struct ithc_api, m);
 	struct ithc *ithc = a->ithc;
+	struct ithc_api_file *af = kzalloc(sizeof *af, GFP_KERNEL);
+	if (!af) return -ENOMEM;
+	af->api = a;
+	f->private_data = af;
 	if (atomic_fetch_inc(&a->open_count) == 0) CHECK(ithc_set_multitouch, ithc, true);
 	return 0;
 }
 
 static int ithc_api_release(struct inode *n, struct file *f) {
-	struct ithc_api *a = container_of(f->private_data, struct ithc_api, m);
+	struct ithc_api *a = ithc_api_from_file(f);
 	struct ithc *ithc = a->ithc;
 	int c = atomic_dec_return(&a->open_count);
 	if (c == 0) CHECK(ithc_set_multitouch, ithc, false);
 	if (c < 0) pci_err(ithc->pci, "open/release mismatch\n");
+	kfree(f->private_data);
 	return 0;
 }
 
@@ -91,6 +148,7 @@ static const struct file_operations dev_fops = {
 	.llseek = ithc_api_llseek,
 	.read = ithc_api_read,
 	.poll = ithc_api_poll,
+	.mmap = ithc_api_mmap,
 	.open = ithc_api_open,
 	.release = ithc_api_release,
 };
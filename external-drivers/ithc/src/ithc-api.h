@@ -12,5 +12,25 @@ struct ithc_api_header {
 	u32 size;
 };
 
+// Layout of the first page of an mmap of the chardev. The data buffers follow it, slot i starting at offset PAGE_SIZE + i * slot_size.
+#define ITHC_API_RING_VERSION 1
+struct ithc_api_ring_slot {
+	u32 msg_num; // message currently held by the slot
+	u32 size;
+	u64 irq_ns; // CLOCK_MONOTONIC time of the interrupt that delivered the message (0 when polling)
+	u64 rx_ns; // CLOCK_MONOTONIC time the message was made available
+};
+struct ithc_api_ring {
+	u32 version;
+	u32 hdr_size;
+	u32 num_slots;
+	u32 slot_size;
+	u32 head; // number of the next message, written after its slot
+	u32 tail; // oldest message whose data is still valid, written before a buffer is reused
+	u32 reserved[2];
+	struct ithc_api_ring_slot slots[NUM_RX_ALLOC];
+};
+_Static_assert(sizeof(struct ithc_api_ring) <= PAGE_SIZE, "ring header must fit in one page");
+
 int ithc_api_init(struct ithc *ithc, struct ithc_dma_rx *rx, const char *name);
 
@@ -74,6 +74,50 @@ static const struct file_operations ithc_debugfops_cmd = {
 	.write = ithc_debugfs_cmd_write,
 };
 
+static ssize_t ithc_debugfs_stats_read(struct file *f, char __user *buf, size_t len, loff_t *offset) {
+	struct ithc *ithc = file_inode(f)->i_private;
+	struct ithc_activity *act = &ithc->activity;
+	char s[512];
+	u64 qos_ns = ithc_qos_active_ns(ithc);
+	u64 uptime = ktime_get_ns() - act->start_ns;
+	int n = scnprintf(s, sizeof s,
+		"frames: %llu\n"
+		"frame interval: %llu us\n"
+		"irq to frame processed: avg %llu us, max %llu us\n"
+		"qos latency: %i us\n"
+		"qos arms: %llu\n"
+		"qos active: %llu ms of %llu ms (%llu%%)\n",
+		act->frames, act->interval_ns / 1000,
+		act->latency_ns / 1000, act->latency_max_ns / 1000,
+		act->qos_latency,
+		act->qos_arms,
+		qos_ns / NSEC_PER_MSEC, uptime / NSEC_PER_MSEC, uptime ? div64_u64(qos_ns * 100, uptime) : 0);
+	return simple_read_from_buffer(buf, len, offset, s, n);
+}
+
+static const struct file_operations ithc_debugfops_stats = {
+	.owner = THIS_MODULE,
+	.read = ithc_debugfs_stats_read,
+};
+
+static ssize_t ithc_debugfs_irq_hist_read(struct file *f, char __user *buf, size_t len, loff_t *offset) {
+	struct ithc *ithc = file_inode(f)->i_private;
+	struct ithc_irq_stats *st = &ithc->irq_stats;
+	char s[512];
+	int n = scnprintf(s, sizeof s, "count: %llu\navg: %llu ns\nmax: %llu ns\n",
+		st->count, st->count ? div64_u64(st->total_ns, st->count) : 0, st->max_ns);
+	for (unsigned i = 0; i < ITHC_IRQ_HIST_BUCKETS; i++) {
+		if (i < ITHC_IRQ_HIST_BUCKETS - 1) n += scnprintf(s + n, sizeof s - n, "<%u us: %llu\n", 1u << i, st->hist[i]);
+		else n += scnprintf(s + n, sizeof s - n, ">=%u us: %llu\n", 1u << (i - 1), st->hist[i]);
+	}
+	return simple_read_from_buffer(buf, len, offset, s, n);
+}
+
+static const struct file_operations ithc_debugfops_irq_hist = {
+	.owner = THIS_MODULE,
+	.read = ithc_debugfs_irq_hist_read,
+};
+
 static void ithc_debugfs_devres_release(struct device *dev, void *res) {
 	struct dentry **dbgm = res;
 	if (*dbgm) debugfs_remove_recursive(*dbgm);
@@ -89,6 +133,10 @@ int ithc_debug_init(struct ithc *ithc) {
 
 	struct dentry *cmd = debugfs_create_file("cmd", 0220, dbg, ithc, &ithc_debugfops_cmd);
 	if (IS_ERR(cmd)) return PTR_ERR(cmd);
+	struct dentry *stats = debugfs_create_file("stats", 0444, dbg, ithc, &ithc_debugfops_stats);
+	if (IS_ERR(stats)) return PTR_ERR(stats);
+	struct dentry *irq_hist = debugfs_create_file("irq_hist", 0444, dbg, ithc, &ithc_debugfops_irq_hist);
+	if (IS_ERR(irq_hist)) return PTR_ERR(irq_hist);
 
 	return 0;
 }
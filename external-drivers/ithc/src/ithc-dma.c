@@ -120,6 +120,12 @@ int ithc_dma_rx_init(struct ithc *ithc, u8 channel, const char *devname) {
 	CHECK_RET(ithc_dma_prd_alloc, ithc, &rx->prds, NUM_RX_ALLOC, num_pages, DMA_FROM_DEVICE);
 	for (unsigned i = 0; i < NUM_RX_ALLOC; i++)
 		CHECK_RET(ithc_dma_data_alloc, ithc, &rx->prds, &rx->bufs[i]);
+	rx->ring = (void *)devm_get_free_pages(&ithc->pci->dev, GFP_KERNEL | __GFP_ZERO, 0);
+	if (!rx->ring) return -ENOMEM;
+	rx->ring->version = ITHC_API_RING_VERSION;
+	rx->ring->hdr_size = sizeof *rx->ring;
+	rx->ring->num_slots = NUM_RX_ALLOC;
+	rx->ring->slot_size = num_pages * PAGE_SIZE;
 	writeb(DMA_RX_CONTROL2_RESET, &ithc->regs->dma_rx[channel].control2);
 	lo_hi_writeq(rx->prds.dma_addr, &ithc->regs->dma_rx[channel].addr);
 	writeb(NUM_RX_DEV - 1, &ithc->regs->dma_rx[channel].num_bufs);
@@ -218,13 +224,24 @@ static int ithc_dma_rx_unlocked(struct ithc *ithc, u8 channel) {
 		// take the buffer that the device just filled
 		struct ithc_dma_data_buffer *b = &rx->bufs[n % NUM_RX_ALLOC];
 		CHECK_RET(ithc_dma_data_buffer_get, ithc, &rx->prds, b, tail);
+		// tell mmap readers that the oldest message is about to be overwritten, then
 		// give the oldest buffer we have back to the device to replace the buffer we took
+		WRITE_ONCE(rx->ring->tail, n + 1 >= NUM_RX_DEV ? n + 1 - NUM_RX_DEV : 0);
+		smp_wmb();
 		CHECK_RET(ithc_dma_data_buffer_put, ithc, &rx->prds, &rx->bufs[(n + NUM_RX_DEV) % NUM_RX_ALLOC], tail);
+		struct ithc_api_ring_slot *slot = &rx->ring->slots[n % NUM_RX_ALLOC];
+		slot->msg_num = n;
+		slot->size = b->data_size;
+		slot->irq_ns = ithc->poll_thread ? 0 : READ_ONCE(ithc->irq_ns);
+		slot->rx_ns = ktime_get_ns();
+		smp_wmb(); // slot before head
+		WRITE_ONCE(rx->ring->head, n + 1);
 		rx->num_received = ++n;
 		WRITE_ONCE(rx->pos, READ_ONCE(rx->pos) + sizeof(struct ithc_api_header) + b->data_size);
 
 		// process data
 		CHECK(ithc_dma_rx_process_buf, ithc, b, channel, tail);
+		ithc_frame_done(ithc);
 
 		wake_up(&rx->wait);
 	}
@@ -66,6 +66,7 @@ struct ithc_dma_rx {
 	u32 num_received;
 	loff_t pos;
 	struct ithc_api *api;
+	struct ithc_api_ring *ring;
 	struct ithc_dma_prd_buffer prds;
 	struct ithc_dma_data_buffer bufs[NUM_RX_ALLOC];
 	wait_queue_head_t wait;
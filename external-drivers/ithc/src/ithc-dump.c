@@ -6,20 +6,97 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
 
 // Simple debugging utility which dumps data from /dev/ithc.
+// With -m the receive buffers are mapped instead of read, and the latency from interrupt to userspace is printed.
+
+// must match struct ithc_api_ring in ithc-api.h
+struct ring_slot {
+	uint32_t msg_num;
+	uint32_t size;
+	uint64_t irq_ns;
+	uint64_t rx_ns;
+};
+struct ring {
+	uint32_t version;
+	uint32_t hdr_size;
+	uint32_t num_slots;
+	uint32_t slot_size;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t reserved[2];
+	struct ring_slot slots[];
+};
+
+static int dump_mmap(int fd) {
+	long page = sysconf(_SC_PAGESIZE);
+	struct ring *ring = mmap(NULL, page, PROT_READ, MAP_SHARED, fd, 0);
+	if (ring == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	if (ring->version != 1) {
+		fprintf(stderr, "unsupported ring version %"PRIu32"\n", ring->version);
+		return 1;
+	}
+	size_t len = page + (size_t)ring->num_slots * ring->slot_size;
+	uint32_t num_slots = ring->num_slots, slot_size = ring->slot_size;
+	munmap(ring, page);
+	const uint8_t *base = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	ring = (struct ring *)base;
+
+	uint32_t next = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	while (1) {
+		if (poll(&pfd, 1, -1) < 0) {
+			perror("poll");
+			return 1;
+		}
+		uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		for (; next != head; next++) {
+			const struct ring_slot *slot = &ring->slots[next % num_slots];
+			const uint8_t *data = base + page + (size_t)(next % num_slots) * slot_size;
+			uint32_t size = slot->size;
+			uint64_t irq_ns = slot->irq_ns;
+			uint8_t first[16];
+			memcpy(first, data, size < sizeof first ? size : sizeof first);
+			struct timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			uint64_t now = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+			// the data is only valid if the buffer wasn't handed back to the device meanwhile
+			if ((int32_t)(next - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) < 0) {
+				fprintf(stderr, "overrun at message %"PRIu32"\n", next);
+				continue;
+			}
+			printf("%10"PRIu32" %5"PRIu32": latency %"PRIu64" us |", next, size, irq_ns ? (now - irq_ns) / 1000 : 0);
+			for (uint32_t j = 0; j < sizeof first && j < size; j++) printf(" %02x", first[j]);
+			printf("\n");
+		}
+	}
+	return 0;
+}
 
 int main(int argc, char **argv) {
-	if (argc != 2) {
-		fprintf(stderr, "usage: %s DEVICE\n", argv[0]);
+	int use_mmap = argc == 3 && !strcmp(argv[1], "-m");
+	if (argc != 2 && !use_mmap) {
+		fprintf(stderr, "usage: %s [-m] DEVICE\n", argv[0]);
 		return 1;
 	}
 
-	int fd = open(argv[1], O_RDONLY);
+	int fd = open(argv[argc - 1], O_RDONLY);
 	if (fd < 0) {
 		perror("open");
 		return 1;
 	}
+	if (use_mmap) return dump_mmap(fd);
 	//lseek(fd, 0, SEEK_END);
 
 	uint8_t buf[0x10000];
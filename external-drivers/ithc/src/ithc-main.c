@@ -39,6 +39,22 @@ static bool ithc_use_rx1 = true;
 module_param_named(rx1, ithc_use_rx1, bool, 0);
 MODULE_PARM_DESC(rx1, "Use DMA RX channel 1");
 
+static int ithc_qos_latency = 0;
+module_param_named(qos_latency, ithc_qos_latency, int, 0644);
+MODULE_PARM_DESC(qos_latency, "CPU latency limit in us requested while touch frames are arriving (-1 to disable)");
+
+static unsigned ithc_qos_intervals = 8;
+module_param_named(qos_intervals, ithc_qos_intervals, uint, 0644);
+MODULE_PARM_DESC(qos_intervals, "Keep the CPU latency limit for this many average frame intervals after the last frame");
+
+static unsigned ithc_qos_timeout = 1000;
+module_param_named(qos_timeout, ithc_qos_timeout, uint, 0644);
+MODULE_PARM_DESC(qos_timeout, "Maximum time in ms the CPU latency limit is kept after the last frame");
+
+static bool ithc_log_irq_regs = false;
+module_param_named(irqregs, ithc_log_irq_regs, bool, 0644);
+MODULE_PARM_DESC(irqregs, "Log a snapshot of the status registers on every interrupt (needs dyndbg)");
+
 static bool ithc_log_regs_enabled = false;
 module_param_named(logregs, ithc_log_regs_enabled, bool, 0);
 MODULE_PARM_DESC(logregs, "Log changes in register values (for debugging)");
@@ -202,7 +218,15 @@ static int ithc_input_init(struct ithc *ithc) {
 
 static void ithc_activity_timer_callback(struct timer_list *t) {
 	struct ithc *ithc = container_of(t, struct ithc, activity_timer);
-	cpu_latency_qos_update_request(&ithc->activity_qos, PM_QOS_DEFAULT_VALUE);
+	struct ithc_activity *act = &ithc->activity;
+	spin_lock(&act->lock);
+	// a frame that arrived while we were waiting for the lock re-armed the timer, keep the request
+	if (!timer_pending(t) && test_bit(0, &act->qos_active)) {
+		cpu_latency_qos_update_request(&ithc->activity_qos, PM_QOS_DEFAULT_VALUE);
+		act->qos_active_ns += ktime_get_ns() - act->qos_start_ns;
+		clear_bit(0, &act->qos_active);
+	}
+	spin_unlock(&act->lock);
 }
 
 void ithc_set_active(struct ithc *ithc) {
@@ -210,8 +234,44 @@ void ithc_set_active(struct ithc *ithc) {
 	// This disrupts DMA, causing truncated DMA messages. ERROR_FLAG_DMA_UNKNOWN_12 will be set when this happens.
 	// The amount of truncated messages can become very high, resulting in user-visible effects (laggy/stuttering cursor).
 	// To avoid this, we use a CPU latency QoS request to prevent the CPU from entering low power states during touch interactions.
-	cpu_latency_qos_update_request(&ithc->activity_qos, 0);
-	mod_timer(&ithc->activity_timer, jiffies + msecs_to_jiffies(1000));
+	// The request is only updated when a burst of frames starts, and released a few frame intervals after the last frame.
+	struct ithc_activity *act = &ithc->activity;
+	u64 now = ktime_get_ns();
+	u64 max_ns = (u64)ithc_qos_timeout * NSEC_PER_MSEC;
+	u64 delta = now - act->last_frame_ns;
+	act->last_frame_ns = now;
+	act->frames++;
+	// gaps longer than the timeout start a new burst and don't count towards the interval
+	if (delta < max_ns) act->interval_ns = act->interval_ns ? (act->interval_ns * 7 + delta) / 8 : delta;
+
+	int latency = READ_ONCE(ithc_qos_latency);
+	if (latency < 0) return;
+	u64 timeout = clamp_t(u64, act->interval_ns * ithc_qos_intervals, 20 * NSEC_PER_MSEC, max(max_ns, 20 * NSEC_PER_MSEC));
+	// arming and releasing the request are serialized with the timer callback by act->lock
+	spin_lock_bh(&act->lock);
+	if (!test_and_set_bit(0, &act->qos_active)) {
+		act->qos_start_ns = now;
+		act->qos_arms++;
+		act->qos_latency = latency;
+		cpu_latency_qos_update_request(&ithc->activity_qos, latency);
+	}
+	mod_timer(&ithc->activity_timer, jiffies + nsecs_to_jiffies(timeout) + 1);
+	spin_unlock_bh(&act->lock);
+}
+
+void ithc_frame_done(struct ithc *ithc) {
+	struct ithc_activity *act = &ithc->activity;
+	if (ithc->poll_thread) return;
+	u64 lat = ktime_get_ns() - READ_ONCE(ithc->irq_ns);
+	act->latency_ns = act->latency_ns ? (act->latency_ns * 7 + lat) / 8 : lat;
+	if (lat > act->latency_max_ns) act->latency_max_ns = lat;
+}
+
+u64 ithc_qos_active_ns(struct ithc *ithc) {
+	struct ithc_activity *act = &ithc->activity;
+	u64 t = act->qos_active_ns;
+	if (test_bit(0, &act->qos_active)) t += ktime_get_ns() - act->qos_start_ns;
+	return t;
 }
 
 static int ithc_set_device_enabled(struct ithc *ithc, bool enable) {
@@ -264,27 +324,50 @@ static void ithc_process(struct ithc *ithc) {
 	ithc_log_regs(ithc);
 }
 
+static irqreturn_t ithc_interrupt(int irq, void *arg) {
+	struct ithc *ithc = arg;
+	// timestamp for the mmap ring, so userspace can measure interrupt to consumption latency
+	WRITE_ONCE(ithc->irq_ns, ktime_get_ns());
+	return IRQ_WAKE_THREAD;
+}
+
+static void ithc_irq_account(struct ithc *ithc, u64 ns) {
+	struct ithc_irq_stats *st = &ithc->irq_stats;
+	u64 us = ns / 1000;
+	st->count++;
+	st->total_ns += ns;
+	if (ns > st->max_ns) st->max_ns = ns;
+	st->hist[min_t(unsigned, fls64(us), ITHC_IRQ_HIST_BUCKETS - 1)]++;
+}
+
 static irqreturn_t ithc_interrupt_thread(int irq, void *arg) {
 	struct ithc *ithc = arg;
-	pci_dbg(ithc->pci, "IRQ! err=%08x/%08x/%08x, cmd=%02x/%08x, rx0=%02x/%08x, rx1=%02x/%08x, tx=%02x/%08x\n",
-		readl(&ithc->regs->error_control), readl(&ithc->regs->error_status), readl(&ithc->regs->error_flags),
-		readb(&ithc->regs->spi_cmd.control), readl(&ithc->regs->spi_cmd.status),
-		readb(&ithc->regs->dma_rx[0].control), readl(&ithc->regs->dma_rx[0].status),
-		readb(&ithc->regs->dma_rx[1].control), readl(&ithc->regs->dma_rx[1].status),
-		readb(&ithc->regs->dma_tx.control), readl(&ithc->regs->dma_tx.status));
+	u64 t = ktime_get_ns();
+	// Each MMIO read is a full PCIe round trip, so the snapshot is opt-in. The hot path only
+	// reads the error flags and the head pointer of the enabled rx channels.
+	if (unlikely(READ_ONCE(ithc_log_irq_regs)))
+		pci_dbg(ithc->pci, "IRQ! err=%08x/%08x/%08x, cmd=%02x/%08x, rx0=%02x/%08x, rx1=%02x/%08x, tx=%02x/%08x\n",
+			readl(&ithc->regs->error_control), readl(&ithc->regs->error_status), readl(&ithc->regs->error_flags),
+			readb(&ithc->regs->spi_cmd.control), readl(&ithc->regs->spi_cmd.status),
+			readb(&ithc->regs->dma_rx[0].control), readl(&ithc->regs->dma_rx[0].status),
+			readb(&ithc->regs->dma_rx[1].control), readl(&ithc->regs->dma_rx[1].status),
+			readb(&ithc->regs->dma_tx.control), readl(&ithc->regs->dma_tx.status));
 	ithc_process(ithc);
+	ithc_irq_account(ithc, ktime_get_ns() - t);
 	return IRQ_HANDLED;
 }
 
 static int ithc_poll_thread(void *arg) {
+	// Fallback for systems where the interrupt can't be used (see README). While frames are arriving, poll at
+	// half the measured frame interval (but at most every 2 ms), then back off to 200 ms when idle.
 	struct ithc *ithc = arg;
-	unsigned sleep = 100;
+	unsigned sleep = 100000; // us
 	while (!kthread_should_stop()) {
 		u32 n = ithc->dma_rx[1].num_received;
 		ithc_process(ithc);
-		if (n != ithc->dma_rx[1].num_received) sleep = 20;
-		else sleep = min(200u, sleep + (sleep >> 4) + 1);
-		msleep_interruptible(sleep);
+		if (n != ithc->dma_rx[1].num_received) sleep = clamp_t(u64, ithc->activity.interval_ns / 2000, 2000, 20000);
+		else sleep = min(200000u, sleep + (sleep >> 4) + 1);
+		usleep_range(sleep, sleep + sleep / 8);
 	}
 	return 0;
 }
@@ -433,7 +516,9 @@ static int ithc_probe(struct pci_dev *pci, const struct pci_device_id *id) {
 	else CHECK_RET(ithc_input_init, ithc);
 
 	cpu_latency_qos_add_request(&ithc->activity_qos, PM_QOS_DEFAULT_VALUE);
+	spin_lock_init(&ithc->activity.lock);
 	timer_setup(&ithc->activity_timer, ithc_activity_timer_callback, 0);
+	ithc->activity.start_ns = ktime_get_ns();
 
 	// add ithc_stop callback AFTER setting up DMA buffers, so that polling/irqs/DMA are disabled BEFORE the buffers are freed
 	CHECK_RET(devm_add_action_or_reset, &pci->dev, ithc_stop, ithc);
@@ -448,7 +533,7 @@ static int ithc_probe(struct pci_dev *pci, const struct pci_device_id *id) {
 			return err;
 		}
 	} else {
-		CHECK_RET(devm_request_threaded_irq, &pci->dev, ithc->irq, NULL, ithc_interrupt_thread, IRQF_TRIGGER_HIGH | IRQF_ONESHOT, DEVNAME, ithc);
+		CHECK_RET(devm_request_threaded_irq, &pci->dev, ithc->irq, ithc_interrupt, ithc_interrupt_thread, IRQF_TRIGGER_HIGH | IRQF_ONESHOT, DEVNAME, ithc);
 	}
 
 	if (ithc_use_rx0) ithc_dma_rx_enable(ithc, 0);
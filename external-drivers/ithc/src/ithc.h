@@ -13,6 +13,8 @@
 #include <linux/poll.h>
 #include <linux/timer.h>
 #include <linux/pm_qos.h>
+#include <linux/mm.h>
+#include <linux/version.h>
 
 #define DEVNAME "ithc"
 #define DEVFULLNAME "Intel Touch Host Controller"
@@ -32,6 +34,31 @@ _Static_assert(NUM_RX_ALLOC % NUM_RX_DEV == 0, "NUM_RX_ALLOC must be a multiple
 struct ithc;
 struct ithc_api;
 
+// Interrupt thread handling time, log2 buckets in us: <1, <2, <4, ..., <1024, >=1024.
+#define ITHC_IRQ_HIST_BUCKETS 12
+struct ithc_irq_stats {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+	u64 hist[ITHC_IRQ_HIST_BUCKETS];
+};
+
+// Touch activity tracking, used for the CPU latency QoS policy and exposed in debugfs.
+struct ithc_activity {
+	spinlock_t lock; // protects arming/releasing the QoS request
+	unsigned long qos_active; // bit 0: QoS request is armed
+	int qos_latency; // latency limit of the current/last request
+	u64 start_ns;
+	u64 last_frame_ns;
+	u64 interval_ns; // average interval between frames of a burst
+	u64 frames;
+	u64 latency_ns; // average time from interrupt to frame processed
+	u64 latency_max_ns;
+	u64 qos_arms;
+	u64 qos_start_ns;
+	u64 qos_active_ns; // total time the QoS request was armed
+};
+
 #include "ithc-regs.h"
 #include "ithc-dma.h"
 #include "ithc-api.h"
@@ -40,9 +67,12 @@ struct ithc {
 	char phys[32];
 	struct pci_dev *pci;
 	int irq;
+	u64 irq_ns;
 	struct task_struct *poll_thread;
 	struct pm_qos_request activity_qos;
 	struct timer_list activity_timer;
+	struct ithc_activity activity;
+	struct ithc_irq_stats irq_stats;
 
 	struct input_dev *input;
 
@@ -63,6 +93,8 @@ struct ithc {
 
 int ithc_reset(struct ithc *ithc);
 void ithc_set_active(struct ithc *ithc);
+void ithc_frame_done(struct ithc *ithc);
+u64 ithc_qos_active_ns(struct ithc *ithc);
 int ithc_debug_init(struct ithc *ithc);
 void ithc_log_regs(struct ithc *ithc);
 